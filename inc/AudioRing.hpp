@@ -0,0 +1,69 @@
+#ifndef NES_AUDIO_RING_HPP
+#define NES_AUDIO_RING_HPP
+
+#include "Blip_Buffer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace nes
+{
+
+	// lock free sample queue from the emulator (single producer) to the audio callback (single consumer)
+	class AudioRing
+	{
+	public:
+
+		explicit AudioRing( size_t capacity = DefaultCapacity );
+
+		AudioRing( const AudioRing& ) = delete;
+		AudioRing& operator=( const AudioRing& ) = delete;
+
+		// rounded up to a power of two, only while neither side is running
+		void setCapacity( size_t capacity );
+		size_t getCapacity() const { return m_buffer.size(); }
+
+		// samples queued before playback starts and again after an underrun
+		void setLatencyTarget( size_t samples );
+		size_t getLatencyTarget() const { return m_latencyTarget.load( std::memory_order_relaxed ); }
+
+		// producer: queue samples, returns how many fit, the rest are dropped as an overrun
+		size_t write( const blip_sample_t* samples, size_t count );
+
+		// consumer: always fills count samples, padding with silence when empty
+		void read( blip_sample_t* out, size_t count );
+
+		// samples queued, approximate from the other side
+		size_t size() const;
+
+		// number of reads that ran dry and writes that were cut short
+		uint64_t getUnderruns() const { return m_underruns.load( std::memory_order_relaxed ); }
+		uint64_t getOverruns() const { return m_overruns.load( std::memory_order_relaxed ); }
+
+		// drop queued samples and reset the counters, only while neither side is running
+		void clear();
+
+		static constexpr size_t DefaultCapacity = 8192;
+
+	private:
+
+		std::vector<blip_sample_t> m_buffer;
+		size_t m_mask = 0;
+
+		// free running positions, each only written by one side
+		alignas( 64 ) std::atomic<size_t> m_writePosition{ 0 };
+		alignas( 64 ) std::atomic<size_t> m_readPosition{ 0 };
+
+		std::atomic<size_t> m_latencyTarget{ 0 };
+		std::atomic<uint64_t> m_underruns{ 0 };
+		std::atomic<uint64_t> m_overruns{ 0 };
+
+		// consumer only, waiting for the latency target to be queued
+		bool m_filling = true;
+	};
+
+}
+
+#endif
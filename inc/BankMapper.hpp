@@ -1,6 +1,7 @@
 #ifndef BANK_MAPPER_HPP
 #define BANK_MAPPER_HPP
 
+#include "ByteIO.hpp"
 #include <stdx/assert.h>
 #include "types.hpp"
 
@@ -16,23 +17,26 @@ namespace nes
 
 		static_assert( NUM_SLOTS > 0 );
 		static_assert( MIN_BANK_SIZE > 0 );
+		static_assert( ( MIN_BANK_SIZE & ( MIN_BANK_SIZE - 1 ) ) == 0, "minimum bank size must be a power of two" );
 
-		BankMapper() = default;
-		BankMapper( size_t memorySize ) : m_memorySize( memorySize )
+		static constexpr size_t SlotShift = []
 		{
-			dbAssert( m_memorySize >= NUM_SLOTS * MIN_BANK_SIZE );
-			dbAssert( m_memorySize % MIN_BANK_SIZE == 0 );
+			size_t shift = 0;
+			while ( ( size_t( 1 ) << shift ) < MIN_BANK_SIZE )
+				++shift;
+			return shift;
+		}();
+		static constexpr size_t SlotMask = MIN_BANK_SIZE - 1;
 
-			reset();
+		BankMapper() = default;
+		BankMapper( const Byte* memory, size_t memorySize )
+		{
+			setMemory( memory, memorySize );
 		}
 
 		void setBank( size_t slot, int bank )
 		{
-			// wrap bank number
-			if ( bank < 0 )
-				bank += m_memorySize / MIN_BANK_SIZE;
-
-			m_bankOffsets[ slot ] = ( bank * MIN_BANK_SIZE ) % m_memorySize;
+			setBank( slot, bank, MIN_BANK_SIZE );
 		}
 
 		// for sizes larger than min bank size
@@ -45,43 +49,100 @@ namespace nes
 			if ( bank < 0 )
 				bank += static_cast<int>( m_memorySize / bankSize );
 
-			size_t numSlots = bankSize / MIN_BANK_SIZE;
+			const size_t numSlots = bankSize / MIN_BANK_SIZE;
+			const size_t firstSlot = slot * numSlots;
+			dbAssert( firstSlot + numSlots <= NUM_SLOTS );
+
+			// wrapping here keeps the lookups free of it
 			for( size_t i = 0; i < numSlots; ++i )
-			{
-				size_t offset = ( bank * bankSize ) + ( i * MIN_BANK_SIZE );
-				m_bankOffsets[ i + slot * numSlots ] = offset % m_memorySize;
-			}
+				m_slots[ firstSlot + i ] = m_memory + wrapOffset( bank * bankSize + i * MIN_BANK_SIZE );
+		}
+
+		// first byte of the MIN_BANK_SIZE bytes mapped to a slot, for consumers that read a whole slot
+		const Byte* getSlot( size_t slot ) const
+		{
+			dbAssert( slot < NUM_SLOTS );
+			return m_slots[ slot ];
+		}
+
+		size_t getBankOffset( size_t slot ) const
+		{
+			return static_cast<size_t>( getSlot( slot ) - m_memory );
 		}
 
 		constexpr size_t bankSize() const { return MIN_BANK_SIZE; }
 		constexpr size_t numSlots() const { return NUM_SLOTS; }
 
-		size_t operator[]( Word address )
+		const Byte* getPointer( Word address ) const
 		{
-			size_t slot = address / MIN_BANK_SIZE;
+			const size_t slot = address >> SlotShift;
 			dbAssert( slot < NUM_SLOTS );
-			return ( address % MIN_BANK_SIZE ) + m_bankOffsets[ slot ];
+			return m_slots[ slot ] + ( address & SlotMask );
+		}
+
+		Byte operator[]( Word address ) const
+		{
+			return *getPointer( address );
+		}
+
+		// offset into memory of a mapped address
+		size_t getOffset( Word address ) const
+		{
+			return static_cast<size_t>( getPointer( address ) - m_memory );
 		}
 
 		void reset()
 		{
 			for( size_t i = 0; i < NUM_SLOTS; ++i )
-			{
-				m_bankOffsets[ i ] = ( i * MIN_BANK_SIZE ) % m_memorySize;
-			}
+				m_slots[ i ] = m_memory + wrapOffset( i * MIN_BANK_SIZE );
 		}
 
-		void setMemorySize( size_t memorySize )
+		void setMemory( const Byte* memory, size_t memorySize )
 		{
+			dbAssert( memorySize > 0 );
+			dbAssert( memorySize % MIN_BANK_SIZE == 0 );
+
+			m_memory = memory;
 			m_memorySize = memorySize;
+			reset();
+		}
+
+		void saveState( ByteIO::Writer& writer ) const
+		{
+			size_t offsets[ NUM_SLOTS ];
+			for( size_t i = 0; i < NUM_SLOTS; ++i )
+				offsets[ i ] = getBankOffset( i );
+
+			writer.write( offsets );
+		}
+
+		void loadState( ByteIO::Reader& reader )
+		{
+			size_t offsets[ NUM_SLOTS ];
+			reader.read( offsets );
+
+			for( size_t i = 0; i < NUM_SLOTS; ++i )
+				m_slots[ i ] = m_memory + wrapOffset( offsets[ i ] & ~SlotMask );
+		}
+
+	private:
+
+		size_t wrapOffset( size_t offset ) const
+		{
+			// most ROM sizes are a power of two so the division is rarely needed
+			if ( ( m_memorySize & ( m_memorySize - 1 ) ) == 0 )
+				return offset & ( m_memorySize - 1 );
+
+			return offset % m_memorySize;
 		}
 
 	private:
 
-		size_t m_bankOffsets[ NUM_SLOTS ];
+		const Byte* m_slots[ NUM_SLOTS ] = {};
+		const Byte* m_memory = nullptr;
 		size_t m_memorySize = 0;
 	};
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -3,10 +3,11 @@
 
 #include <stdx/assert.h>
 
-#include <iostream>
+#include <cstring>
 #include <memory>
 #include <stdexcept>
 #include <string_view>
+#include <type_traits>
 
 namespace ByteIO
 {
@@ -16,29 +17,37 @@ class Exception : public std::runtime_error
 	using std::runtime_error::runtime_error;
 };
 
+// writes into a caller provided buffer, or only counts bytes when there is no buffer
 class Writer
 {
 public:
 
-	Writer( std::ostream& stream ) : m_stream( stream ) {}
+	Writer() = default;
+
+	Writer( void* data, size_t capacity )
+		: m_data( static_cast<char*>( data ) )
+		, m_capacity( capacity )
+	{}
 
 	template <typename T>
 	std::enable_if_t<!std::is_pointer_v<T>, void>
 	write( const T& value )
 	{
-		m_stream.write( reinterpret_cast<const char*>( std::addressof( value ) ), sizeof( value ) );
-	}
-
-	template <typename T, size_t N>
-	void write( const T array[ N ] )
-	{
-		m_stream.write( &array, sizeof( T ) * N );
+		static_assert( std::is_trivially_copyable_v<T> );
+		write( std::addressof( value ), sizeof( value ) );
 	}
 
 	template <typename T>
 	void write( const T* data, size_t size )
 	{
-		m_stream.write( reinterpret_cast<const char*>( data ), size );
+		if ( m_data )
+		{
+			if ( size > m_capacity - m_size )
+				throw Exception( "State buffer is too small" );
+
+			std::memcpy( m_data + m_size, data, size );
+		}
+		m_size += size;
 	}
 
 	void write( const char* str )
@@ -51,53 +60,75 @@ public:
 		write( str.data(), str.size() );
 	}
 
+	// bytes written so far
+	size_t size() const { return m_size; }
+
 private:
 
-	std::ostream& m_stream;
+	char* m_data = nullptr;
+	size_t m_capacity = 0;
+	size_t m_size = 0;
 };
 
 class Reader
 {
 public:
 
-	Reader( std::istream& stream ) : m_stream( stream ) {}
+	Reader( const void* data, size_t size )
+		: m_data( static_cast<const char*>( data ) )
+		, m_size( size )
+	{}
 
 	template <typename T>
 	std::enable_if_t<!std::is_pointer_v<T>, void>
 	read( T& value )
 	{
-		m_stream.read( reinterpret_cast<char*>( std::addressof( value ) ), sizeof( value ) );
+		static_assert( std::is_trivially_copyable_v<T> );
+		read( std::addressof( value ), sizeof( value ) );
 	}
 
-	template <typename T, size_t N>
-	void read( const T array[ N ] )
+	template <typename T>
+	void read( T* data, size_t size )
 	{
-		m_stream.read( &array, sizeof( T ) * N );
+		std::memcpy( data, take( size ), size );
 	}
 
-	template <typename T>
-	void read( T* data, size_t size )
+	void skip( size_t size )
 	{
-		m_stream.read( reinterpret_cast<char*>( data ), size );
+		take( size );
 	}
 
 	void readHeader( std::string_view str )
 	{
-		for( char c : str )
+		if ( std::string_view( take( str.size() ), str.size() ) != str )
 		{
-			if ( c != m_stream.get() )
-			{
-				dbBreakMessage( "Incorrect header [%s]", str.data() );
-				throw Exception( "Incorrect header" );
-			}
+			dbBreakMessage( "Incorrect header [%s]", str.data() );
+			throw Exception( "Incorrect header" );
 		}
 	}
 
+	// bytes read so far
+	size_t position() const { return m_position; }
+
+private:
+
+	const char* take( size_t size )
+	{
+		if ( size > m_size - m_position )
+			throw Exception( "Unexpected end of state" );
+
+		const char* data = m_data + m_position;
+		m_position += size;
+		return data;
+	}
+
 private:
-	
-	std::istream& m_stream;
+
+	const char* m_data = nullptr;
+	size_t m_size = 0;
+	size_t m_position = 0;
 };
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,54 @@
+#ifndef NES_INPUT_MOVIE_HPP
+#define NES_INPUT_MOVIE_HPP
+
+#include "joypad.hpp"
+#include "types.hpp"
+
+#include <string>
+#include <vector>
+
+namespace nes
+{
+
+	// button presses recorded against frame numbers counted from power on
+	class InputMovie
+	{
+	public:
+
+		struct ButtonPress
+		{
+			int frame;
+			int joypad;
+			Joypad::Button button;
+			bool pressed;
+		};
+
+		bool empty() const { return m_buttonPresses.empty(); }
+		void clear();
+
+		// the checksum identifies the cartridge the movie was recorded with
+		bool save( const std::string& filename, uint32_t checksum ) const;
+		bool load( const std::string& filename );
+		uint32_t getChecksum() const { return m_checksum; }
+
+		void record( int frame, int joypad, Joypad::Button button, bool pressed );
+
+		// restart playback from the first press
+		void rewind() { m_index = 0; }
+
+		// apply presses for this frame, returns false once every press has been applied
+		bool updateInput( int frame, Joypad* joypads, size_t numJoypads );
+
+		// frame of the last press, -1 if empty
+		int getLastFrame() const;
+
+	private:
+
+		std::vector<ButtonPress> m_buttonPresses;
+		size_t m_index = 0;
+		uint32_t m_checksum = 0;
+	};
+
+}
+
+#endif
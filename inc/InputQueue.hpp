@@ -0,0 +1,57 @@
+#ifndef NES_INPUT_QUEUE_HPP
+#define NES_INPUT_QUEUE_HPP
+
+#include "joypad.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+namespace nes
+{
+
+	struct InputEvent
+	{
+		using Clock = std::chrono::steady_clock;
+
+		Clock::time_point time;
+		int joypad = 0;
+		Joypad::Button button = Joypad::NONE;
+		bool pressed = false;
+	};
+
+	// lock free queue of button changes from the event thread (single producer) to the emulator thread (single consumer)
+	// events are timestamped so each frame only takes the input that happened before it was due
+	class InputQueue
+	{
+	public:
+
+		InputQueue() = default;
+
+		InputQueue( const InputQueue& ) = delete;
+		InputQueue& operator=( const InputQueue& ) = delete;
+
+		// producer: false if the queue is full and the event was dropped
+		bool push( const InputEvent& event );
+
+		// consumer: take the oldest event if it happened at or before time
+		bool pop( InputEvent& event, InputEvent::Clock::time_point time );
+
+		// consumer: drop every queued event
+		void clear();
+
+		static constexpr size_t Capacity = 256;
+
+	private:
+
+		std::array<InputEvent, Capacity> m_events;
+
+		// free running positions, each only written by one side
+		alignas( 64 ) std::atomic<size_t> m_writePosition{ 0 };
+		alignas( 64 ) std::atomic<size_t> m_readPosition{ 0 };
+	};
+
+}
+
+#endif
@@ -1,6 +1,10 @@
 #ifndef CPU_INSTRUCTIONS
 #define CPU_INSTRUCTIONS
 
+#include "enum_iterator.hpp"
+
+#include <iterator>
+
 namespace nes
 {
 
@@ -103,7 +107,108 @@ enum class Instruction
 };
 constexpr Instruction enum_back( Instruction ) noexcept { return Instruction::ignoreByte; }
 
-const char* getInstructionName( Instruction instr );
+inline constexpr const char* InstructionNames[] = {
+	"ADC",
+	"AND",
+	"ASL",
+
+	"BCC",
+	"BCS",
+	"BEQ",
+	"BIT",
+	"BMI",
+	"BNE",
+	"BPL",
+	"BRK",
+	"BVC",
+	"BVS",
+
+	"CLC",
+	"CLD",
+	"CLI",
+	"CLV",
+	"CMP",
+	"CPX",
+	"CPY",
+
+	"DEC",
+	"DEX",
+	"DEY",
+
+	"EOR",
+
+	"INC",
+	"INX",
+	"INY",
+
+	"JMP",
+	"JSR",
+
+	"LDA",
+	"LDX",
+	"LDY",
+	"LSR",
+
+	"NOP",
+
+	"ORA",
+
+	"PHA",
+	"PHP",
+	"PLA",
+	"PLP",
+
+	"ROL",
+	"ROR",
+	"RTI",
+	"RTS",
+
+	"SBC",
+	"SEC",
+	"SED",
+	"SEI",
+	"STA",
+	"STX",
+	"STY",
+
+	"TAX",
+	"TAY",
+	"TSX",
+	"TXA",
+	"TXS",
+	"TYA",
+
+	"ILL",
+
+	// unofficial
+	"ALR",
+	"ANC",
+	"ARR",
+	"AXS",
+	"LAX",
+	"SAX",
+	"DCP",
+	"ISC",
+	"RLA",
+	"RRA",
+	"SLO",
+	"SRE",
+	"XAA",
+	"OAL",
+	"SXA",
+	"SYA",
+	"XAS",
+	"AXA",
+	"LAR",
+	"IGN"
+};
+
+static_assert( std::size( InstructionNames ) == enum_size_v<Instruction> );
+
+constexpr const char* getInstructionName( Instruction instr )
+{
+	return InstructionNames[ static_cast<size_t>( instr ) ];
+}
 
 }
 
@@ -4,30 +4,67 @@
 #include <stdx/assert.h>
 #include "types.hpp"
 
+#include <functional>
 #include <memory>
+#include <typeindex>
+#include <utility>
 
 namespace nes
 {
 
+	class FileMapping;
+
+	// heap memory, or a read only file mapping shared by every Memory mapping the same file
 	class Memory
 	{
 	public:
 
 		Memory() = default;
 		Memory( size_t dataSize )
-			: m_data( std::make_unique<Byte[]>( dataSize ) )
+			: m_buffer( std::make_unique<Byte[]>( dataSize ) )
+			, m_data( m_buffer.get() )
 			, m_size( dataSize )
 		{}
 		Memory( const Memory& ) = delete;
-		Memory( Memory&& ) = default;
+		Memory( Memory&& other ) noexcept
+		{
+			*this = std::move( other );
+		}
 
 		Memory& operator=( const Memory& ) = delete;
-		Memory& operator=( Memory&& ) = default;
+		Memory& operator=( Memory&& other ) noexcept
+		{
+			m_buffer = std::move( other.m_buffer );
+			m_mapping = std::move( other.m_mapping );
+			m_data = std::exchange( other.m_data, nullptr );
+			m_size = std::exchange( other.m_size, 0 );
+			return *this;
+		}
+
+		// maps a whole file read only, reusing the mapping of a live Memory if the file is unchanged
+		// returns empty memory if the file cannot be mapped
+		static Memory mapFile( const char* filename );
+
+		bool isReadOnly() const { return m_mapping != nullptr; }
+
+		// data computed from the contents, built once per file mapping and shared by every Memory using it
+		// heap memory has nothing to share it with so it is always built
+		template <typename T, typename Build>
+		std::shared_ptr<const T> share( Build build ) const
+		{
+			if ( !isReadOnly() )
+				return std::make_shared<const T>( build() );
+
+			return std::static_pointer_cast<const T>( getShared( typeid( T ), [&]() -> std::shared_ptr<const void>
+			{
+				return std::make_shared<const T>( build() );
+			} ) );
+		}
 
 		Byte& operator[]( size_t index )
 		{
 			dbAssertMessage( index < m_size, "index (%zu) out of bounds (%zu)", index, m_size );
-			return m_data[ index ];
+			return data()[ index ];
 		}
 		Byte operator[]( size_t index ) const
 		{
@@ -37,8 +74,12 @@ namespace nes
 
 		size_t size() const { return m_size; }
 
-		Byte* data() { return m_data.get(); }
-		const Byte* data() const { return m_data.get(); }
+		Byte* data()
+		{
+			dbAssertMessage( !isReadOnly(), "memory is read only" );
+			return m_data;
+		}
+		const Byte* data() const { return m_data; }
 
 		Byte* begin() { return data(); }
 		const Byte* begin() const { return cbegin(); }
@@ -50,10 +91,16 @@ namespace nes
 
 	private:
 
-		std::unique_ptr<Byte[]> m_data;
+		std::shared_ptr<const void> getShared( std::type_index type, const std::function<std::shared_ptr<const void>()>& build ) const;
+
+	private:
+
+		std::unique_ptr<Byte[]> m_buffer;
+		std::shared_ptr<FileMapping> m_mapping;
+		Byte* m_data = nullptr;
 		size_t m_size = 0;
 	};
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -2,14 +2,15 @@
 #define NES_HPP
 
 #include "apu.hpp"
-#include "Cartridge.hpp"
-#include "Cpu.hpp"
+#include "cartridge.hpp"
+#include "cpu.hpp"
 #include <stdx/assert.h>
-#include "Ppu.hpp"
+#include "ppu.hpp"
+#include "Snapshot.hpp"
 
 #include <iostream>
-
-struct Pixel;
+#include <iterator>
+#include <vector>
 
 namespace nes
 {
@@ -54,7 +55,16 @@ namespace nes
 			ppu.setCartridge( cartridge.get() );
 			
 			if ( cartridge )
+			{
 				cartridge->setCPU( cpu );
+				updateSnapshotSize();
+			}
+			else
+			{
+				m_snapshotSize = 0;
+			}
+
+			m_runAheadState.resize( m_snapshotSize );
 		}
 
 		void setController( Controller* controller, size_t port )
@@ -62,16 +72,44 @@ namespace nes
 			cpu.setController( controller, port );
 		}
 
-		const Pixel* getPixelBuffer() const
+		const Byte* getFrameBuffer() const
+		{
+			return ppu.getFrameBuffer();
+		}
+
+		// pixels must hold Ppu::ScreenWidth * Ppu::ScreenHeight entries
+		void getPixels( Pixel* pixels ) const
 		{
-			return ppu.getPixelBuffer();
+			Ppu::convertFrame( ppu.getFrameBuffer(), pixels );
 		}
 
 		void runFrame()
 		{
+			const bool runningAhead = m_runAheadFrames > 0 && cartridge;
+			const bool output = ppu.getRenderOutput();
+
+			// when running ahead only the last hidden frame is shown
+			if ( runningAhead )
+				ppu.setRenderOutput( false );
+
 			cpu.runFrame();
+
+			if ( runningAhead && !cpu.halted() )
+				runAhead( output );
+
+			ppu.setRenderOutput( output );
 		}
 
+		// show frames emulated ahead of the input to hide latency
+		int getRunAhead() const { return m_runAheadFrames; }
+		void setRunAhead( int frames )
+		{
+			dbAssert( 0 <= frames && frames <= MaxRunAhead );
+			m_runAheadFrames = frames;
+		}
+
+		static constexpr int MaxRunAhead = 4;
+
 		bool halted() const
 		{
 			return cpu.halted();
@@ -87,33 +125,93 @@ namespace nes
 			ppu.setSpriteFlickering( on );
 		}
 
+		// see Ppu::setRenderOutput, headless runs that don't need pixels can leave it off
+		void setRenderOutput( bool on )
+		{
+			ppu.setRenderOutput( on );
+		}
+
+		// a fixed alignment makes power on deterministic, see Ppu::setClockSyncAlignment
+		void setClockSyncAlignment( int alignment )
+		{
+			ppu.setClockSyncAlignment( alignment );
+		}
+
+		// see Cpu::setIdleLoopSkipping
+		void setIdleLoopSkipping( bool skip )
+		{
+			cpu.setIdleLoopSkipping( skip );
+		}
+
 		void setMute( bool mute )
 		{
 			apu.setMute( mute );
 		}
 
-		void saveState( std::ostream& out )
+		void setSampleOutput( Apu::SampleOutput output )
+		{
+			apu.setSampleOutput( std::move( output ) );
+		}
+
+		// see Apu::setClockRateScale
+		void setAudioClockRateScale( double scale )
+		{
+			apu.setClockRateScale( scale );
+		}
+
+		// ntsc frames per second, 29780.5 cpu cycles each
+		static constexpr double FrameRate = Apu::ClockRate / 29780.5;
+
+		// exact size of a snapshot of the current cartridge
+		size_t getSnapshotSize() const { return m_snapshotSize; }
+
+		// returns the number of bytes written, throws ByteIO::Exception if the buffer is too small
+		size_t saveSnapshot( void* data, size_t size )
 		{
 			dbAssert( cartridge );
 
-			ByteIO::Writer writer( out );
+			cpu.syncPpu();
+
+			ByteIO::Writer writer( data, size );
+			writer.write( Snapshot::Header{ Snapshot::Magic, Snapshot::Version, static_cast<uint32_t>( m_snapshotSize ), Snapshot::NumSections } );
 
-			cpu.saveState( out );
-			ppu.saveState( out );
-			apu.saveState( writer );
-			cartridge->saveState( writer );
+			for( size_t i = 0; i < Snapshot::NumSections; ++i )
+			{
+				writer.write( Snapshot::SectionHeader{ Snapshot::SectionTags[ i ], m_sectionSizes[ i ] } );
+				saveSection( writer, static_cast<Snapshot::Section>( i ) );
+			}
+
+			dbAssert( writer.size() == m_snapshotSize );
+			return writer.size();
 		}
 
-		void loadState( std::istream& in )
+		// the layout is checked before loading, throws ByteIO::Exception if it doesn't match the cartridge
+		void loadSnapshot( const void* data, size_t size )
 		{
 			dbAssert( cartridge );
 
-			ByteIO::Reader reader( in );
+			ByteIO::Reader reader( data, size );
+			validateSnapshot( reader );
+			reader.skip( sizeof( Snapshot::Header ) );
+
+			for( size_t i = 0; i < Snapshot::NumSections; ++i )
+			{
+				reader.skip( sizeof( Snapshot::SectionHeader ) );
+				loadSection( reader, static_cast<Snapshot::Section>( i ) );
+			}
+		}
+
+		void saveState( std::ostream& out )
+		{
+			std::vector<char> buffer( m_snapshotSize );
+			saveSnapshot( buffer.data(), buffer.size() );
+			out.write( buffer.data(), buffer.size() );
+		}
 
-			cpu.loadState( in );
-			ppu.loadState( in );
-			apu.loadState( reader );
-			cartridge->loadState( reader );
+		void loadState( std::istream& in )
+		{
+			std::vector<char> buffer( std::istreambuf_iterator<char>( in ), {} );
+			loadSnapshot( buffer.data(), buffer.size() );
 		}
 
 		void dump()
@@ -130,6 +228,100 @@ namespace nes
 		Ppu ppu;
 		Apu apu;
 		std::unique_ptr<Cartridge> cartridge;
+
+	private:
+
+		void saveSection( ByteIO::Writer& writer, Snapshot::Section section )
+		{
+			switch( section )
+			{
+				case Snapshot::CpuSection: cpu.saveState( writer ); break;
+				case Snapshot::PpuSection: ppu.saveState( writer ); break;
+				case Snapshot::ApuSection: apu.saveState( writer ); break;
+				case Snapshot::CartridgeSection: cartridge->saveState( writer ); break;
+				default: dbBreak();
+			}
+		}
+
+		void loadSection( ByteIO::Reader& reader, Snapshot::Section section )
+		{
+			switch( section )
+			{
+				case Snapshot::CpuSection: cpu.loadState( reader ); break;
+				case Snapshot::PpuSection: ppu.loadState( reader ); break;
+				case Snapshot::ApuSection: apu.loadState( reader ); break;
+				case Snapshot::CartridgeSection: cartridge->loadState( reader ); break;
+				default: dbBreak();
+			}
+		}
+
+		// section sizes only depend on the cartridge's memory sizes
+		void updateSnapshotSize()
+		{
+			ByteIO::Writer counter;
+			counter.write( Snapshot::Header{} );
+
+			for( size_t i = 0; i < Snapshot::NumSections; ++i )
+			{
+				counter.write( Snapshot::SectionHeader{} );
+
+				const size_t start = counter.size();
+				saveSection( counter, static_cast<Snapshot::Section>( i ) );
+				m_sectionSizes[ i ] = static_cast<uint32_t>( counter.size() - start );
+			}
+
+			m_snapshotSize = counter.size();
+		}
+
+		void validateSnapshot( ByteIO::Reader reader ) const
+		{
+			Snapshot::Header header;
+			reader.read( header );
+
+			if ( header.magic != Snapshot::Magic )
+				throw ByteIO::Exception( "Not a save state" );
+
+			if ( header.version != Snapshot::Version )
+				throw ByteIO::Exception( "Unsupported save state version" );
+
+			if ( header.size != m_snapshotSize || header.numSections != Snapshot::NumSections )
+				throw ByteIO::Exception( "Save state doesn't match the cartridge" );
+
+			for( size_t i = 0; i < Snapshot::NumSections; ++i )
+			{
+				Snapshot::SectionHeader section;
+				reader.read( section );
+
+				if ( section.tag != Snapshot::SectionTags[ i ] || section.size != m_sectionSizes[ i ] )
+					throw ByteIO::Exception( "Save state doesn't match the cartridge" );
+
+				reader.skip( section.size );
+			}
+		}
+
+		void runAhead( bool output )
+		{
+			saveSnapshot( m_runAheadState.data(), m_runAheadState.size() );
+
+			// the frame buffer isn't part of the state so it keeps the last hidden frame
+			apu.setOutputSuppressed( true );
+			for( int i = 0; i < m_runAheadFrames && !cpu.halted(); ++i )
+			{
+				ppu.setRenderOutput( output && i == m_runAheadFrames - 1 );
+				cpu.runFrame();
+			}
+
+			loadSnapshot( m_runAheadState.data(), m_runAheadState.size() );
+			apu.setOutputSuppressed( false );
+		}
+
+	private:
+
+		size_t m_snapshotSize = 0;
+		uint32_t m_sectionSizes[ Snapshot::NumSections ]{};
+
+		std::vector<Byte> m_runAheadState;
+		int m_runAheadFrames = 0;
 	};
 
 }
@@ -0,0 +1,403 @@
+#ifndef NES_OPCODES_HPP
+#define NES_OPCODES_HPP
+
+#include "Instructions.hpp"
+#include "types.hpp"
+
+#include <array>
+
+// every documented and supported undocumented opcode with its operation and address mode
+#define CPU_OPERATIONS( ADDRMODE_OP, IMPLIED, BRANCH ) \
+	ADDRMODE_OP( 0x69, addWithCarry, Immediate ) \
+	ADDRMODE_OP( 0x65, addWithCarry, ZeroPage ) \
+	ADDRMODE_OP( 0x75, addWithCarry, ZeroPageX ) \
+	ADDRMODE_OP( 0x6d, addWithCarry, Absolute ) \
+	ADDRMODE_OP( 0x7d, addWithCarry, AbsoluteX ) \
+	ADDRMODE_OP( 0x79, addWithCarry, AbsoluteY ) \
+	ADDRMODE_OP( 0x61, addWithCarry, IndirectX ) \
+	ADDRMODE_OP( 0x71, addWithCarry, IndirectY ) \
+	\
+	ADDRMODE_OP( 0x29, bitwiseAnd, Immediate ) \
+	ADDRMODE_OP( 0x25, bitwiseAnd, ZeroPage ) \
+	ADDRMODE_OP( 0x35, bitwiseAnd, ZeroPageX ) \
+	ADDRMODE_OP( 0x2d, bitwiseAnd, Absolute ) \
+	ADDRMODE_OP( 0x3d, bitwiseAnd, AbsoluteX ) \
+	ADDRMODE_OP( 0x39, bitwiseAnd, AbsoluteY ) \
+	ADDRMODE_OP( 0x21, bitwiseAnd, IndirectX ) \
+	ADDRMODE_OP( 0x31, bitwiseAnd, IndirectY ) \
+	\
+	ADDRMODE_OP( 0x0a, shiftLeft, Accumulator ) \
+	ADDRMODE_OP( 0x06, shiftLeft, ZeroPage ) \
+	ADDRMODE_OP( 0x16, shiftLeft, ZeroPageX ) \
+	ADDRMODE_OP( 0x0e, shiftLeft, Absolute ) \
+	ADDRMODE_OP( 0x1e, shiftLeft, AbsoluteXStore ) \
+	\
+	BRANCH( 0x90, branchOnCarryClear ) \
+	BRANCH( 0xb0, branchOnCarrySet ) \
+	BRANCH( 0xf0, branchOnZero ) \
+	\
+	ADDRMODE_OP( 0x24, testBits, ZeroPage ) \
+	ADDRMODE_OP( 0x2c, testBits, Absolute ) \
+	\
+	BRANCH( 0x30, branchOnNegative ) \
+	BRANCH( 0xd0, branchOnNotZero ) \
+	BRANCH( 0x10, branchOnPositive ) \
+	\
+	IMPLIED( 0x00, forceBreak ) \
+	\
+	BRANCH( 0x50, branchOnOverflowClear ) \
+	BRANCH( 0x70, branchOnOverflowSet ) \
+	\
+	IMPLIED( 0x18, clearCarryFlag ) \
+	IMPLIED( 0xd8, clearDecimalFlag ) \
+	IMPLIED( 0x58, clearInterruptDisableFlag ) \
+	IMPLIED( 0xb8, clearOverflowFlag ) \
+	\
+	ADDRMODE_OP( 0xc9, compareWithAcc, Immediate ) \
+	ADDRMODE_OP( 0xc5, compareWithAcc, ZeroPage ) \
+	ADDRMODE_OP( 0xd5, compareWithAcc, ZeroPageX ) \
+	ADDRMODE_OP( 0xcd, compareWithAcc, Absolute ) \
+	ADDRMODE_OP( 0xdd, compareWithAcc, AbsoluteX ) \
+	ADDRMODE_OP( 0xd9, compareWithAcc, AbsoluteY ) \
+	ADDRMODE_OP( 0xc1, compareWithAcc, IndirectX ) \
+	ADDRMODE_OP( 0xd1, compareWithAcc, IndirectY ) \
+	\
+	ADDRMODE_OP( 0xe0, compareWithX, Immediate ) \
+	ADDRMODE_OP( 0xe4, compareWithX, ZeroPage ) \
+	ADDRMODE_OP( 0xec, compareWithX, Absolute ) \
+	\
+	ADDRMODE_OP( 0xc0, compareWithY, Immediate ) \
+	ADDRMODE_OP( 0xc4, compareWithY, ZeroPage ) \
+	ADDRMODE_OP( 0xcc, compareWithY, Absolute ) \
+	\
+	ADDRMODE_OP( 0xc6, decrement, ZeroPage ) \
+	ADDRMODE_OP( 0xd6, decrement, ZeroPageX ) \
+	ADDRMODE_OP( 0xce, decrement, Absolute ) \
+	ADDRMODE_OP( 0xde, decrement, AbsoluteXStore ) \
+	\
+	IMPLIED( 0xca, decrementX ) \
+	IMPLIED( 0x88, decrementY ) \
+	\
+	ADDRMODE_OP( 0x49, exclusiveOr, Immediate ) \
+	ADDRMODE_OP( 0x45, exclusiveOr, ZeroPage ) \
+	ADDRMODE_OP( 0x55, exclusiveOr, ZeroPageX ) \
+	ADDRMODE_OP( 0x4d, exclusiveOr, Absolute ) \
+	ADDRMODE_OP( 0x5d, exclusiveOr, AbsoluteX ) \
+	ADDRMODE_OP( 0x59, exclusiveOr, AbsoluteY ) \
+	ADDRMODE_OP( 0x41, exclusiveOr, IndirectX ) \
+	ADDRMODE_OP( 0x51, exclusiveOr, IndirectY ) \
+	\
+	ADDRMODE_OP( 0xe6, increment, ZeroPage ) \
+	ADDRMODE_OP( 0xf6, increment, ZeroPageX ) \
+	ADDRMODE_OP( 0xee, increment, Absolute ) \
+	ADDRMODE_OP( 0xfe, increment, AbsoluteXStore ) \
+	\
+	IMPLIED( 0xe8, incrementX ) \
+	IMPLIED( 0xc8, incrementY ) \
+	\
+	ADDRMODE_OP( 0x4c, jump, Absolute ) \
+	ADDRMODE_OP( 0x6c, jump, Indirect ) \
+	\
+	ADDRMODE_OP( 0x20, jumpToSubroutine, Absolute ) \
+	\
+	ADDRMODE_OP( 0xa9, loadAcc, Immediate ) \
+	ADDRMODE_OP( 0xa5, loadAcc, ZeroPage ) \
+	ADDRMODE_OP( 0xb5, loadAcc, ZeroPageX ) \
+	ADDRMODE_OP( 0xad, loadAcc, Absolute ) \
+	ADDRMODE_OP( 0xbd, loadAcc, AbsoluteX ) \
+	ADDRMODE_OP( 0xb9, loadAcc, AbsoluteY ) \
+	ADDRMODE_OP( 0xa1, loadAcc, IndirectX ) \
+	ADDRMODE_OP( 0xb1, loadAcc, IndirectY ) \
+	\
+	ADDRMODE_OP( 0xa2, loadX, Immediate ) \
+	ADDRMODE_OP( 0xa6, loadX, ZeroPage ) \
+	ADDRMODE_OP( 0xb6, loadX, ZeroPageY ) \
+	ADDRMODE_OP( 0xae, loadX, Absolute ) \
+	ADDRMODE_OP( 0xbe, loadX, AbsoluteY ) \
+	\
+	ADDRMODE_OP( 0xa0, loadY, Immediate ) \
+	ADDRMODE_OP( 0xa4, loadY, ZeroPage ) \
+	ADDRMODE_OP( 0xb4, loadY, ZeroPageX ) \
+	ADDRMODE_OP( 0xac, loadY, Absolute ) \
+	ADDRMODE_OP( 0xbc, loadY, AbsoluteX ) \
+	\
+	ADDRMODE_OP( 0x4a, shiftRight, Accumulator ) \
+	ADDRMODE_OP( 0x46, shiftRight, ZeroPage ) \
+	ADDRMODE_OP( 0x56, shiftRight, ZeroPageX ) \
+	ADDRMODE_OP( 0x4e, shiftRight, Absolute ) \
+	ADDRMODE_OP( 0x5e, shiftRight, AbsoluteXStore ) \
+	\
+	IMPLIED( 0xea, noOperation ) \
+	\
+	ADDRMODE_OP( 0x09, bitwiseOr, Immediate ) \
+	ADDRMODE_OP( 0x05, bitwiseOr, ZeroPage ) \
+	ADDRMODE_OP( 0x15, bitwiseOr, ZeroPageX ) \
+	ADDRMODE_OP( 0x0d, bitwiseOr, Absolute ) \
+	ADDRMODE_OP( 0x1d, bitwiseOr, AbsoluteX ) \
+	ADDRMODE_OP( 0x19, bitwiseOr, AbsoluteY ) \
+	ADDRMODE_OP( 0x01, bitwiseOr, IndirectX ) \
+	ADDRMODE_OP( 0x11, bitwiseOr, IndirectY ) \
+	\
+	IMPLIED( 0x48, pushAcc ) \
+	IMPLIED( 0x08, pushStatus ) \
+	IMPLIED( 0x68, popAcc ) \
+	IMPLIED( 0x28, popStatus ) \
+	\
+	ADDRMODE_OP( 0x2a, rotateLeft, Accumulator ) \
+	ADDRMODE_OP( 0x26, rotateLeft, ZeroPage ) \
+	ADDRMODE_OP( 0x36, rotateLeft, ZeroPageX ) \
+	ADDRMODE_OP( 0x2e, rotateLeft, Absolute ) \
+	ADDRMODE_OP( 0x3e, rotateLeft, AbsoluteXStore ) \
+	\
+	ADDRMODE_OP( 0x6a, rotateRight, Accumulator ) \
+	ADDRMODE_OP( 0x66, rotateRight, ZeroPage ) \
+	ADDRMODE_OP( 0x76, rotateRight, ZeroPageX ) \
+	ADDRMODE_OP( 0x6e, rotateRight, Absolute ) \
+	ADDRMODE_OP( 0x7e, rotateRight, AbsoluteXStore ) \
+	\
+	IMPLIED( 0x40, returnFromInterrupt ) \
+	\
+	IMPLIED( 0x60, returnFromSubroutine ) \
+	\
+	ADDRMODE_OP( 0xe9, subtractFromAcc, Immediate ) \
+	ADDRMODE_OP( 0xe5, subtractFromAcc, ZeroPage ) \
+	ADDRMODE_OP( 0xf5, subtractFromAcc, ZeroPageX ) \
+	ADDRMODE_OP( 0xed, subtractFromAcc, Absolute ) \
+	ADDRMODE_OP( 0xfd, subtractFromAcc, AbsoluteX ) \
+	ADDRMODE_OP( 0xf9, subtractFromAcc, AbsoluteY ) \
+	ADDRMODE_OP( 0xe1, subtractFromAcc, IndirectX ) \
+	ADDRMODE_OP( 0xf1, subtractFromAcc, IndirectY ) \
+	\
+	IMPLIED( 0x38, setCarryFlag ) \
+	IMPLIED( 0xf8, setDecimalFlag ) \
+	IMPLIED( 0x78, setInterruptDisableFlag ) \
+	\
+	ADDRMODE_OP( 0x85, storeAcc, ZeroPage ) \
+	ADDRMODE_OP( 0x95, storeAcc, ZeroPageX ) \
+	ADDRMODE_OP( 0x8d, storeAcc, Absolute ) \
+	ADDRMODE_OP( 0x9d, storeAcc, AbsoluteXStore ) \
+	ADDRMODE_OP( 0x99, storeAcc, AbsoluteYStore ) \
+	ADDRMODE_OP( 0x81, storeAcc, IndirectX ) \
+	ADDRMODE_OP( 0x91, storeAcc, IndirectYStore ) \
+	\
+	ADDRMODE_OP( 0x86, storeX, ZeroPage ) \
+	ADDRMODE_OP( 0x96, storeX, ZeroPageY ) \
+	ADDRMODE_OP( 0x8e, storeX, Absolute ) \
+	\
+	ADDRMODE_OP( 0x84, storeY, ZeroPage ) \
+	ADDRMODE_OP( 0x94, storeY, ZeroPageX ) \
+	ADDRMODE_OP( 0x8c, storeY, Absolute ) \
+	\
+	IMPLIED( 0xaa, transferAccToX ) \
+	IMPLIED( 0xa8, transferAccToY ) \
+	IMPLIED( 0xba, transferStackPointerToX ) \
+	IMPLIED( 0x8a, transferXToAcc ) \
+	IMPLIED( 0x9a, transferXToStackPointer ) \
+	IMPLIED( 0x98, transferYToAcc ) \
+	\
+	/* unofficial: */ \
+	\
+	ADDRMODE_OP( 0x4b, andShiftRight, Immediate ) \
+	\
+	ADDRMODE_OP( 0x0b, andSetCarry, Immediate ) \
+	ADDRMODE_OP( 0x2b, andSetCarry, Immediate ) \
+	\
+	ADDRMODE_OP( 0x6b, andRotateRight, Immediate ) \
+	\
+	ADDRMODE_OP( 0xcb, subtractFromAccAndX, Immediate ) \
+	\
+	ADDRMODE_OP( 0xa3, loadAccTransferToX, IndirectX ) \
+	ADDRMODE_OP( 0xa7, loadAccTransferToX, ZeroPage ) \
+	ADDRMODE_OP( 0xab, loadAccTransferToX, Immediate ) \
+	ADDRMODE_OP( 0xaf, loadAccTransferToX, Absolute ) \
+	ADDRMODE_OP( 0xb3, loadAccTransferToX, IndirectY ) \
+	ADDRMODE_OP( 0xb7, loadAccTransferToX, ZeroPageY ) \
+	ADDRMODE_OP( 0xbf, loadAccTransferToX, AbsoluteY ) \
+	\
+	ADDRMODE_OP( 0x83, storeAccAndX, IndirectX ) \
+	ADDRMODE_OP( 0x87, storeAccAndX, ZeroPage ) \
+	ADDRMODE_OP( 0x8f, storeAccAndX, Absolute ) \
+	ADDRMODE_OP( 0x97, storeAccAndX, ZeroPageY ) \
+	\
+	ADDRMODE_OP( 0xc3, decrementCompare, IndirectX ) \
+	ADDRMODE_OP( 0xc7, decrementCompare, ZeroPage ) \
+	ADDRMODE_OP( 0xcf, decrementCompare, Absolute ) \
+	ADDRMODE_OP( 0xd3, decrementCompare, IndirectYStore ) \
+	ADDRMODE_OP( 0xd7, decrementCompare, ZeroPageX ) \
+	ADDRMODE_OP( 0xdb, decrementCompare, AbsoluteYStore ) \
+	ADDRMODE_OP( 0xdf, decrementCompare, AbsoluteXStore ) \
+	\
+	ADDRMODE_OP( 0xe3, incrementSubtract, IndirectX ) \
+	ADDRMODE_OP( 0xe7, incrementSubtract, ZeroPage ) \
+	ADDRMODE_OP( 0xef, incrementSubtract, Absolute ) \
+	ADDRMODE_OP( 0xf3, incrementSubtract, IndirectYStore ) \
+	ADDRMODE_OP( 0xf7, incrementSubtract, ZeroPageX ) \
+	ADDRMODE_OP( 0xfb, incrementSubtract, AbsoluteYStore ) \
+	ADDRMODE_OP( 0xff, incrementSubtract, AbsoluteXStore ) \
+	\
+	ADDRMODE_OP( 0x23, rotateLeftAnd, IndirectX ) \
+	ADDRMODE_OP( 0x27, rotateLeftAnd, ZeroPage ) \
+	ADDRMODE_OP( 0x2f, rotateLeftAnd, Absolute ) \
+	ADDRMODE_OP( 0x33, rotateLeftAnd, IndirectYStore ) \
+	ADDRMODE_OP( 0x37, rotateLeftAnd, ZeroPageX ) \
+	ADDRMODE_OP( 0x3b, rotateLeftAnd, AbsoluteYStore ) \
+	ADDRMODE_OP( 0x3f, rotateLeftAnd, AbsoluteXStore ) \
+	\
+	ADDRMODE_OP( 0x63, rotateRightAdd, IndirectX ) \
+	ADDRMODE_OP( 0x67, rotateRightAdd, ZeroPage ) \
+	ADDRMODE_OP( 0x6f, rotateRightAdd, Absolute ) \
+	ADDRMODE_OP( 0x73, rotateRightAdd, IndirectYStore ) \
+	ADDRMODE_OP( 0x77, rotateRightAdd, ZeroPageX ) \
+	ADDRMODE_OP( 0x7b, rotateRightAdd, AbsoluteYStore ) \
+	ADDRMODE_OP( 0x7f, rotateRightAdd, AbsoluteXStore ) \
+	\
+	ADDRMODE_OP( 0x03, shiftLeftOrAcc, IndirectX ) \
+	ADDRMODE_OP( 0x07, shiftLeftOrAcc, ZeroPage ) \
+	ADDRMODE_OP( 0x0f, shiftLeftOrAcc, Absolute ) \
+	ADDRMODE_OP( 0x13, shiftLeftOrAcc, IndirectYStore ) \
+	ADDRMODE_OP( 0x17, shiftLeftOrAcc, ZeroPageX ) \
+	ADDRMODE_OP( 0x1b, shiftLeftOrAcc, AbsoluteYStore ) \
+	ADDRMODE_OP( 0x1f, shiftLeftOrAcc, AbsoluteXStore ) \
+	\
+	ADDRMODE_OP( 0x43, shiftRightExclusiveOr, IndirectX ) \
+	ADDRMODE_OP( 0x47, shiftRightExclusiveOr, ZeroPage ) \
+	ADDRMODE_OP( 0x4f, shiftRightExclusiveOr, Absolute ) \
+	ADDRMODE_OP( 0x53, shiftRightExclusiveOr, IndirectYStore ) \
+	ADDRMODE_OP( 0x57, shiftRightExclusiveOr, ZeroPageX ) \
+	ADDRMODE_OP( 0x5b, shiftRightExclusiveOr, AbsoluteYStore ) \
+	ADDRMODE_OP( 0x5f, shiftRightExclusiveOr, AbsoluteXStore ) \
+	\
+	ADDRMODE_OP( 0xeb, subtractFromAcc, Immediate ) \
+	\
+	ADDRMODE_OP( 0x8b, transferXToAccAnd, Immediate ) \
+	\
+	IMPLIED( 0x9e, andXAddrHigh ) \
+	IMPLIED( 0x9c, andYAddrHigh ) \
+	\
+	ADDRMODE_OP( 0x9b, andXAccStoreStackPointer, AbsoluteYStore ) \
+	\
+	ADDRMODE_OP( 0x9f, andXAccSeven, AbsoluteYStore ) \
+	ADDRMODE_OP( 0x93, andXAccSeven, IndirectYStore ) \
+	\
+	ADDRMODE_OP( 0xbb, andSPTransferToAcXSP, AbsoluteY ) \
+	\
+	IMPLIED( 0x1a, noOperation ) \
+	IMPLIED( 0x3a, noOperation ) \
+	IMPLIED( 0x5a, noOperation ) \
+	IMPLIED( 0x7a, noOperation ) \
+	IMPLIED( 0xda, noOperation ) \
+	IMPLIED( 0xfa, noOperation ) \
+	\
+	ADDRMODE_OP( 0x0c, ignoreByte, Absolute ) \
+	ADDRMODE_OP( 0x1c, ignoreByte, AbsoluteX ) \
+	ADDRMODE_OP( 0x3c, ignoreByte, AbsoluteX ) \
+	ADDRMODE_OP( 0x5c, ignoreByte, AbsoluteX ) \
+	ADDRMODE_OP( 0x7c, ignoreByte, AbsoluteX ) \
+	ADDRMODE_OP( 0xdc, ignoreByte, AbsoluteX ) \
+	ADDRMODE_OP( 0xfc, ignoreByte, AbsoluteX ) \
+	ADDRMODE_OP( 0x04, ignoreByte, ZeroPage ) \
+	ADDRMODE_OP( 0x14, ignoreByte, ZeroPageX ) \
+	ADDRMODE_OP( 0x34, ignoreByte, ZeroPageX ) \
+	ADDRMODE_OP( 0x44, ignoreByte, ZeroPage ) \
+	ADDRMODE_OP( 0x54, ignoreByte, ZeroPageX ) \
+	ADDRMODE_OP( 0x64, ignoreByte, ZeroPage ) \
+	ADDRMODE_OP( 0x74, ignoreByte, ZeroPageX ) \
+	ADDRMODE_OP( 0x80, ignoreByte, Immediate ) \
+	ADDRMODE_OP( 0x82, ignoreByte, Immediate ) \
+	ADDRMODE_OP( 0x89, ignoreByte, Immediate ) \
+	ADDRMODE_OP( 0xc2, ignoreByte, Immediate ) \
+	ADDRMODE_OP( 0xd4, ignoreByte, ZeroPageX ) \
+	ADDRMODE_OP( 0xe2, ignoreByte, Immediate ) \
+	ADDRMODE_OP( 0xf4, ignoreByte, ZeroPageX )
+
+namespace nes
+{
+
+	struct Opcode
+	{
+		Instruction instruction = Instruction::illegalOpcode;
+		const char* mnemonic = getInstructionName( Instruction::illegalOpcode );
+		const char* addressMode = "Implied";
+		Byte cycles = 0; // without page crossing and taken branch penalties
+		Byte length = 1; // including the opcode
+	};
+
+	// bytes taken by each address mode including the opcode
+	namespace OpcodeLength
+	{
+		constexpr Byte Immediate = 2;
+		constexpr Byte Absolute = 3;
+		constexpr Byte ZeroPage = 2;
+		constexpr Byte ZeroPageX = 2;
+		constexpr Byte ZeroPageY = 2;
+		constexpr Byte Implied = 1;
+		constexpr Byte Accumulator = 1;
+		constexpr Byte AbsoluteX = 3;
+		constexpr Byte AbsoluteXStore = 3;
+		constexpr Byte AbsoluteY = 3;
+		constexpr Byte AbsoluteYStore = 3;
+		constexpr Byte Indirect = 3;
+		constexpr Byte IndirectX = 2;
+		constexpr Byte IndirectY = 2;
+		constexpr Byte IndirectYStore = 2;
+		constexpr Byte Relative = 2;
+	}
+
+	// documented timings, unsupported opcodes halt the cpu instead
+	inline constexpr Byte OpcodeCycles[ 0x100 ] =
+	{
+	//	0  1  2  3  4  5  6  7  8  9  a  b  c  d  e  f
+		7, 6, 2, 8, 3, 3, 5, 5, 3, 2, 2, 2, 4, 4, 6, 6, // 0
+		2, 5, 2, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7, // 1
+		6, 6, 2, 8, 3, 3, 5, 5, 4, 2, 2, 2, 4, 4, 6, 6, // 2
+		2, 5, 2, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7, // 3
+		6, 6, 2, 8, 3, 3, 5, 5, 3, 2, 2, 2, 3, 4, 6, 6, // 4
+		2, 5, 2, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7, // 5
+		6, 6, 2, 8, 3, 3, 5, 5, 4, 2, 2, 2, 5, 4, 6, 6, // 6
+		2, 5, 2, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7, // 7
+		2, 6, 2, 6, 3, 3, 3, 3, 2, 2, 2, 2, 4, 4, 4, 4, // 8
+		2, 6, 2, 6, 4, 4, 4, 4, 2, 5, 2, 5, 5, 5, 5, 5, // 9
+		2, 6, 2, 6, 3, 3, 3, 3, 2, 2, 2, 2, 4, 4, 4, 4, // a
+		2, 5, 2, 5, 4, 4, 4, 4, 2, 4, 2, 4, 4, 4, 4, 4, // b
+		2, 6, 2, 8, 3, 3, 5, 5, 2, 2, 2, 2, 4, 4, 6, 6, // c
+		2, 5, 2, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7, // d
+		2, 6, 2, 8, 3, 3, 5, 5, 2, 2, 2, 2, 4, 4, 6, 6, // e
+		2, 5, 2, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7, // f
+	};
+
+#define OPCODE_ADDRMODE_OP( opcode, instr, addrmode ) \
+	table[ opcode ] = { Instruction::instr, getInstructionName( Instruction::instr ), #addrmode, OpcodeCycles[ opcode ], OpcodeLength::addrmode };
+
+#define OPCODE_IMPLIED( opcode, instr ) \
+	table[ opcode ] = { Instruction::instr, getInstructionName( Instruction::instr ), "Implied", OpcodeCycles[ opcode ], OpcodeLength::Implied };
+
+#define OPCODE_BRANCH( opcode, instr ) \
+	table[ opcode ] = { Instruction::instr, getInstructionName( Instruction::instr ), "Relative", OpcodeCycles[ opcode ], OpcodeLength::Relative };
+
+	constexpr std::array<Opcode, 0x100> makeOpcodeTable()
+	{
+		std::array<Opcode, 0x100> table{};
+		for( size_t i = 0; i < table.size(); ++i )
+			table[ i ].cycles = OpcodeCycles[ i ];
+
+		CPU_OPERATIONS( OPCODE_ADDRMODE_OP, OPCODE_IMPLIED, OPCODE_BRANCH )
+
+		// SYA and SXA are dispatched as implied but decode their own indexed operand
+		table[ 0x9c ].addressMode = "AbsoluteX";
+		table[ 0x9c ].length = OpcodeLength::AbsoluteX;
+		table[ 0x9e ].addressMode = "AbsoluteY";
+		table[ 0x9e ].length = OpcodeLength::AbsoluteY;
+
+		return table;
+	}
+
+	// metadata for every opcode, unsupported ones are illegalOpcode
+	inline constexpr std::array<Opcode, 0x100> OpcodeTable = makeOpcodeTable();
+
+#undef OPCODE_ADDRMODE_OP
+#undef OPCODE_IMPLIED
+#undef OPCODE_BRANCH
+
+}
+
+#endif
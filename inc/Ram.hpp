@@ -59,7 +59,7 @@ namespace nes
 
 	private:
 
-		Byte m_data[ Size ];
+		Byte m_data[ Size ]{};
 	};
 }
 
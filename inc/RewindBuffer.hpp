@@ -0,0 +1,81 @@
+#ifndef NES_REWIND_BUFFER_HPP
+#define NES_REWIND_BUFFER_HPP
+
+#include "types.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nes
+{
+
+	class Nes;
+
+	// history of snapshots for rewinding
+	// the newest snapshot is kept whole and each older one as an XOR/RLE delta against its successor
+	class RewindBuffer
+	{
+	public:
+
+		RewindBuffer() = default;
+		~RewindBuffer();
+
+		RewindBuffer( const RewindBuffer& ) = delete;
+		RewindBuffer& operator=( const RewindBuffer& ) = delete;
+
+		// bytes of history, the newest snapshot included, kept before the oldest deltas are dropped, 0 disables rewinding
+		void setCapacity( size_t capacity );
+		size_t getCapacity() const { return m_capacity; }
+
+		// snapshot the current state, compression happens on a worker thread
+		void push( Nes& nes );
+
+		// load the most recent snapshot not yet loaded, false if there is no older history
+		// the loaded snapshot stays the newest so pushes after rewinding continue from it
+		bool pop( Nes& nes );
+
+		void clear();
+
+		// number of snapshots that can be popped
+		size_t size();
+
+	private:
+
+		void run();
+		void waitUntilIdle( std::unique_lock<std::mutex>& lock );
+		void addState( std::vector<Byte>& state );
+		void evict();
+
+		static void encodeDelta( const std::vector<Byte>& from, const std::vector<Byte>& to, std::vector<Byte>& delta );
+		static void applyDelta( const std::vector<Byte>& delta, std::vector<Byte>& state );
+
+	private:
+
+		size_t m_capacity = 0;
+
+		std::thread m_worker;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_idle;
+
+		// latest snapshot waiting for the worker, replaced if the worker falls behind
+		std::vector<Byte> m_pending;
+		std::vector<Byte> m_pushBuffer;
+		bool m_hasPending = false;
+		bool m_busy = false;
+		bool m_quit = false;
+
+		std::vector<Byte> m_current;
+		std::deque<std::vector<Byte>> m_deltas;
+		size_t m_deltaBytes = 0;
+
+		// m_current was loaded by pop, the next pop steps back past it
+		bool m_currentLoaded = false;
+	};
+
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef NES_SNAPSHOT_HPP
+#define NES_SNAPSHOT_HPP
+
+#include "types.hpp"
+
+namespace nes
+{
+
+	// save state layout: a header followed by one section per component
+	namespace Snapshot
+	{
+		constexpr uint32_t makeTag( const char ( &name )[ 5 ] )
+		{
+			return uint32_t( name[ 0 ] )
+				| ( uint32_t( name[ 1 ] ) << 8 )
+				| ( uint32_t( name[ 2 ] ) << 16 )
+				| ( uint32_t( name[ 3 ] ) << 24 );
+		}
+
+		constexpr uint32_t Magic = makeTag( "NESS" );
+
+		// increment when the contents of any section change
+		constexpr uint32_t Version = 1;
+
+		enum Section
+		{
+			CpuSection,
+			PpuSection,
+			ApuSection,
+			CartridgeSection,
+
+			NumSections
+		};
+
+		constexpr uint32_t SectionTags[ NumSections ] =
+		{
+			makeTag( "CPU " ),
+			makeTag( "PPU " ),
+			makeTag( "APU " ),
+			makeTag( "CART" )
+		};
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t size; // including this header
+			uint32_t numSections;
+		};
+
+		struct SectionHeader
+		{
+			uint32_t tag;
+			uint32_t size; // excluding this header
+		};
+	}
+
+}
+
+#endif
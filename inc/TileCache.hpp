@@ -0,0 +1,80 @@
+#ifndef TILE_CACHE_HPP
+#define TILE_CACHE_HPP
+
+#include <stdx/assert.h>
+#include "types.hpp"
+
+#include <vector>
+
+namespace nes
+{
+
+	// CHR tiles decoded to one palette index byte per pixel, leftmost pixel in the lowest byte
+	class TileCache
+	{
+	public:
+
+		static constexpr size_t TileSize = 16;
+		static constexpr size_t TileHeight = 8;
+
+		static uint64_t decodeRow( Byte low, Byte high )
+		{
+			uint64_t row = 0;
+			for ( size_t x = 0; x < 8; ++x )
+			{
+				const size_t bit = 7 - x;
+				const uint64_t pixel = ( ( low >> bit ) & 1 ) | ( ( ( high >> bit ) & 1 ) << 1 );
+				row |= pixel << ( x * 8 );
+			}
+			return row;
+		}
+
+		// mirror pixels horizontally
+		static uint64_t flipRow( uint64_t row )
+		{
+			row = ( ( row >> 8 ) & 0x00ff00ff00ff00ff ) | ( ( row & 0x00ff00ff00ff00ff ) << 8 );
+			row = ( ( row >> 16 ) & 0x0000ffff0000ffff ) | ( ( row & 0x0000ffff0000ffff ) << 16 );
+			return ( row >> 32 ) | ( row << 32 );
+		}
+
+		void decode( const Byte* chr, size_t size )
+		{
+			dbAssert( size % TileSize == 0 );
+
+			m_rows.resize( size / TileSize * TileHeight );
+			for ( size_t offset = 0; offset < size; offset += TileSize )
+			{
+				for ( size_t y = 0; y < TileHeight; ++y )
+					m_rows[ getIndex( offset + y ) ] = decodeRow( chr[ offset + y ], chr[ offset + y + TileHeight ] );
+			}
+		}
+
+		// redecode the row containing a CHR byte after it was written
+		void update( const Byte* chr, size_t offset )
+		{
+			const size_t lowOffset = offset & ~TileHeight;
+			m_rows[ getIndex( lowOffset ) ] = decodeRow( chr[ lowOffset ], chr[ lowOffset + TileHeight ] );
+		}
+
+		// offset of the low bit plane byte of the row
+		uint64_t getRow( size_t offset ) const
+		{
+			dbAssert( ( offset & TileHeight ) == 0 );
+			return m_rows[ getIndex( offset ) ];
+		}
+
+	private:
+
+		static size_t getIndex( size_t offset )
+		{
+			return ( offset / TileSize ) * TileHeight + ( offset % TileHeight );
+		}
+
+	private:
+
+		std::vector<uint64_t> m_rows;
+	};
+
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef NES_TRIPLE_BUFFER_HPP
+#define NES_TRIPLE_BUFFER_HPP
+
+#include <array>
+#include <atomic>
+
+namespace nes
+{
+
+	// lock free hand over of whole values from one producer thread to one consumer thread
+	// neither side ever waits, the consumer always gets the newest value published
+	template <typename T>
+	class TripleBuffer
+	{
+	public:
+
+		TripleBuffer() = default;
+
+		TripleBuffer( const TripleBuffer& ) = delete;
+		TripleBuffer& operator=( const TripleBuffer& ) = delete;
+
+		// producer: the slot to fill, the consumer can't see it until published
+		T& getBack() { return m_slots[ m_back ]; }
+
+		// producer: hand the back slot over, replacing a value the consumer hasn't taken yet
+		void publish()
+		{
+			m_back = m_middle.exchange( m_back | NewBit, std::memory_order_acq_rel ) & IndexMask;
+		}
+
+		// consumer: take the newest published value, false if there is nothing new
+		bool update()
+		{
+			if ( ( m_middle.load( std::memory_order_relaxed ) & NewBit ) == 0 )
+				return false;
+
+			m_front = m_middle.exchange( m_front, std::memory_order_acq_rel ) & IndexMask;
+			return true;
+		}
+
+		// consumer: the value taken by the last update
+		const T& getFront() const { return m_slots[ m_front ]; }
+
+	private:
+
+		static constexpr unsigned IndexMask = 3;
+		static constexpr unsigned NewBit = 4;
+
+		std::array<T, 3> m_slots{};
+
+		// each index is owned by one side, the middle one is swapped between them
+		alignas( 64 ) unsigned m_back = 0;
+		alignas( 64 ) std::atomic<unsigned> m_middle{ 1 };
+		alignas( 64 ) unsigned m_front = 2;
+	};
+
+}
+
+#endif
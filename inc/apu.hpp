@@ -3,10 +3,12 @@
 
 // blargg apu
 #include "Nes_Apu.h"
-#include "Sound_Queue.h"
+#include "Blip_Buffer.h"
 
 #include "types.hpp"
 
+#include <functional>
+
 namespace ByteIO
 {
 	class Writer;
@@ -19,6 +21,9 @@ namespace nes
 	class Apu
 	{
 	public:
+		// receives the samples of each frame when it ends
+		using SampleOutput = std::function<void( const blip_sample_t*, size_t )>;
+
 		Apu();
 
 		Byte read( cpu_time_t elapsedCycles, Word address );
@@ -27,20 +32,38 @@ namespace nes
 		void reset();
 		void setMute( bool mute );
 		void setDmcReader( dmc_reader_t func );
+		void setSampleOutput( SampleOutput output );
+
+		// scales the clock rate the samples are made at, above 1 gives fewer samples per frame
+		// used to keep an audio queue level against the sound card's clock, the emulation is unaffected
+		void setClockRateScale( double scale );
+
+		// discard sound from frames that won't be shown, eg. when running ahead or rewinding
+		// calls nest, oscillator levels are restored by the outermost unsuppress so load the state before
+		void setOutputSuppressed( bool suppress );
+
+		static constexpr long SampleRate = 48000;
+		static constexpr long ClockRate = 1789773;
 
 		void saveState( ByteIO::Writer& writer ) const;
 		void loadState( ByteIO::Reader& reader );
 
 	private:
+		void updateOutput();
+
 		static const size_t OutBufferSize = 4096;
 
 	    Nes_Apu m_apu;
 	    Blip_Buffer m_buffer;
+	    Blip_Buffer m_hiddenBuffer;
 
-	    Sound_Queue m_soundQueue;
+	    SampleOutput m_sampleOutput;
 
 	    blip_sample_t m_outBuf[ OutBufferSize ];
 
+	    int m_oscAmps[ Nes_Apu::osc_count ]{};
+	    int m_suppressDepth = 0;
+
 	    bool m_muted = false;
 	};
 
@@ -4,8 +4,11 @@
 #include "BankMapper.hpp"
 #include "ByteIO.hpp"
 #include "Memory.hpp"
+#include "TileCache.hpp"
 #include "types.hpp"
 
+#include <memory>
+
 namespace nes
 {
 
@@ -32,18 +35,46 @@ namespace nes
 			*/
 		};
 
+		struct PatternRow
+		{
+			Byte low = 0;
+			Byte high = 0;
+			uint64_t pixels = 0;
+		};
+
 		Cartridge( Memory data );
 
 		virtual ~Cartridge() = default;
 
 		Byte readPRG( Word address );
-		Byte readCHR( Word address );
+
+		// inline so PPU fetches don't pay for a call
+		Byte readCHR( Word address )
+		{
+			return m_chrMap[ address ];
+		}
+
+		// bit planes and decoded pixels of the pattern row starting at a PPU address
+		PatternRow readPatternRow( Word address )
+		{
+			const Byte* row = m_chrMap.getPointer( address );
+			return { row[ 0 ], row[ TileCache::TileHeight ], m_tileCache->getRow( static_cast<size_t>( row - m_chr ) ) };
+		}
 		
 		virtual void writePRG( Word address, Byte value );
 		virtual void writeCHR( Word address, Byte value );
 
+		// PPU events a mapper registers for, they are scheduled so other mappers don't pay for them
+		enum PpuEvent : uint32_t
+		{
+			ScanlineSignal = 1 << 0 // signalScanline on the A12 rise of each rendered scanline
+		};
+		uint32_t getPpuEvents() const { return m_ppuEvents; }
+
 		virtual void signalScanline() {}
-		virtual void setCPU( Cpu& cpu ) {}
+
+		// maps PRG RAM and ROM into the CPU page table
+		void setCPU( Cpu& cpu );
 
 		virtual void reset();
 
@@ -63,15 +94,22 @@ namespace nes
 
 	protected:
 
-		Byte* getPrg() { return m_prg; }
+		Cpu* getCPU() { return m_cpu; }
+
+		const Byte* getPrg() const { return m_prg; }
 		size_t getPrgSize() const { return m_prgSize; }
 
-		Byte* getChr() { return m_chr; }
+		const Byte* getChr() const { return m_chr; }
 		size_t getChrSize() const { return m_chrSize; }
 
 		Byte* getRam() { return m_ram.data(); }
 		size_t getRamSize() const { return m_ram.size(); }
 
+		void setPpuEvents( uint32_t events )
+		{
+			m_ppuEvents = events;
+		}
+
 		void setNameTableMirroring( NameTableMirroring mirroring )
 		{
 			m_mirroring = mirroring;
@@ -80,6 +118,9 @@ namespace nes
 		void setPrgBank( size_t slot, int bank, size_t bankSize )
 		{
 			m_prgMap.setBank( slot, bank, bankSize );
+
+			const size_t numSlots = bankSize / PrgBankSize;
+			mapPrgSlots( slot * numSlots, numSlots );
 		}
 
 		void setChrBank( size_t slot, int bank, size_t bankSize )
@@ -99,14 +140,21 @@ namespace nes
 
 	private:
 
-		Memory m_data;
+		void mapPrgSlots( size_t firstSlot, size_t numSlots );
+
+	private:
+
+		Cpu* m_cpu = nullptr;
+
+		// PRG and CHR ROM, may be a file mapping shared with other cartridges so never written
+		const Memory m_data;
 		Memory m_ram;
 		Memory m_chrRam;
 
-		Byte* m_prg = nullptr;
+		const Byte* m_prg = nullptr;
 		size_t m_prgSize = 0;
 
-		Byte* m_chr = nullptr;
+		const Byte* m_chr = nullptr;
 		size_t m_chrSize = 0;
 
 		NameTableMirroring m_mirroring = NameTableMirroring::Horizontal;
@@ -114,7 +162,13 @@ namespace nes
 		BankMapper<NumPrgSlots, PrgBankSize> m_prgMap;
 		BankMapper<NumChrSlots, ChrBankSize> m_chrMap;
 
+		// indexed by physical CHR offset so bank switching doesn't invalidate it
+		// CHR ROM caches are shared with other cartridges mapping the same file, CHR RAM has its own
+		std::shared_ptr<const TileCache> m_tileCache;
+		std::shared_ptr<TileCache> m_chrRamTileCache;
+
 		uint32_t m_checksum = 0;
+		uint32_t m_ppuEvents = 0;
 	};
 
 }
@@ -4,7 +4,15 @@
 #include "Ram.hpp"
 #include "types.hpp"
 
+#include <array>
 #include <iostream>
+#include <vector>
+
+namespace ByteIO
+{
+	class Writer;
+	class Reader;
+}
 
 namespace nes
 {
@@ -18,6 +26,8 @@ namespace nes
 	{
 	public:
 
+		Cpu();
+
 		void setPPU( Ppu& ppu )
 		{
 			m_ppu = &ppu;
@@ -28,10 +38,7 @@ namespace nes
 			m_apu = &apu;
 		}
 
-		void setCartridge( Cartridge* cartridge )
-		{
-			m_cartridge = cartridge;
-		}
+		void setCartridge( Cartridge* cartridge );
 
 		void setController( Controller* controller, size_t port )
 		{
@@ -43,30 +50,47 @@ namespace nes
 		void executeInstruction();
 		void runFrame();
 
-		void setNMI( bool on = true )
-		{
-			m_nmi = on ? 0 : -1;
-		}
+		// interrupts are timestamped with the PPU clock so they can be raised while the PPU catches up
+		void setNMI( bool on = true );
+		void setIRQ( bool on = true );
 
-		void setIRQ( bool on = true )
-		{
-			m_irq = on ? 0 : -1;
-		}
+		// run the PPU up to the current CPU cycle
+		void syncPpu();
 
 		bool halted() const { return m_halt; }
 
-		void saveState( std::ostream& out ) const;
-		void loadState( std::istream& in );
+		void saveState( ByteIO::Writer& writer ) const;
+		void loadState( ByteIO::Reader& reader );
 
 		// public so APU can read DMC
-		Byte read( Word address );
+		Byte read( Word address )
+		{
+			if ( const Byte* page = m_readPages[ address / PageSize ] )
+				return page[ address % PageSize ];
+
+			return readIO( address );
+		}
+
+		// reads from mapped pages skip the I/O handlers
+		void mapReadPages( Word address, const Byte* data, size_t size );
+		void unmapReadPages( Word address, size_t size );
 
 		void dump( Word address );
 		void dumpStack();
 		void dumpState();
 		Word getProgramCounter() const { return m_programCounter; }
 
-		static void initialize();
+		// cycles elapsed since the start of the current frame
+		int getCycles() const { return m_cycles; }
+
+		// jump over iterations of loops that wait for an interrupt or the PPU, timing is unchanged
+		bool getIdleLoopSkipping() const { return m_idleLoopSkipping; }
+		void setIdleLoopSkipping( bool skip );
+
+		static constexpr int PpuDotsPerCycle = 3;
+
+		static constexpr size_t PageSize = 0x100;
+		static constexpr size_t NumPages = 0x10000 / PageSize;
 
 	private:
 
@@ -86,12 +110,100 @@ namespace nes
 
 		static constexpr Word StackOffset = 0x0100;
 		static constexpr size_t RamSize = 0x0800;
+		static constexpr Word RamMirrorEnd = 0x2000;
+
+		using Operation = void( Cpu::* )( void );
+
+		// handler for each opcode built at compile time, metadata is in Opcodes.hpp
+		static const std::array<Operation, 0x100> s_operations;
+
+		// handlers that take their operand from a decoded block, null for opcodes that must fetch their own
+		static const std::array<Operation, 0x100> s_decodedOperations;
+
+		struct DecodedInstruction
+		{
+			Operation operation = nullptr;
+			Word address = 0;
+			Word operand = 0;
+			Byte length = 0;
+		};
+
+		static constexpr size_t MaxBlockInstructions = 16;
+		static constexpr size_t NumBlocks = 1024;
+		static constexpr size_t NumRamPages = RamSize / PageSize;
+
+		// straight line code up to the next jump, decoded once and keyed by its address and the memory mapped there
+		struct Block
+		{
+			Word address = 0;
+			const Byte* code = nullptr;
+
+			// code in internal ram is dropped when its page is written
+			bool inRam = false;
+			uint32_t ramVersion = 0;
+
+			size_t count = 0;
+			DecodedInstruction instructions[ MaxBlockInstructions ];
+		};
 
 	private:
 
-		void tick();
+		void tick()
+		{
+			m_oddCycle = !m_oddCycle;
+			m_masterClock += PpuDotsPerCycle;
+			++m_cycles;
+		}
+
+		// run one instruction or interrupt, the PPU events must already be synced
+		void step();
+		bool serviceInterrupt();
+		void executeOpcode( Byte opcode );
 
-		void write( Word address, Byte value );
+		// the cached block at the program counter, null where code has to be stepped
+		const Block* findBlock();
+		void decodeBlock( Block& block, Word address, const Byte* code );
+
+		// returns false once the PPU finished the frame
+		bool runBlock( const Block& block );
+
+		void executeDecoded( const DecodedInstruction& instruction );
+
+		void invalidateRamCode( Word address );
+		void invalidateAllRamCode();
+
+		// reads from unmapped pages: registers and cartridge handlers
+		Byte readIO( Word address );
+
+		struct IdleLoop;
+
+		// called when a loop jumps back to its head
+		void checkIdleLoop( Word end );
+		bool analyzeIdleLoop( IdleLoop& loop ) const;
+
+		// catch up the PPU if it may have raised an interrupt or finished a frame
+		void syncPpuEvents();
+
+		bool interruptPending( int64_t time ) const
+		{
+			// interrupts are polled 2 PPU dots after being raised
+			return ( time >= 0 ) && ( m_masterClock - time >= 2 );
+		}
+
+		void write( Word address, Byte value )
+		{
+			// internal ram is mirrored up to the PPU registers
+			if ( address < RamMirrorEnd )
+			{
+				m_ram[ address ] = value;
+				if ( m_ramCodePages & ( 1u << ( address % RamSize / PageSize ) ) )
+					invalidateRamCode( address );
+			}
+			else
+				writeIO( address, value );
+		}
+
+		void writeIO( Word address, Byte value );
 
 		void dummyRead()
 		{
@@ -116,6 +228,36 @@ namespace nes
 			return ( high << 8 ) | low;
 		}
 
+		// operands come from the instruction stream, or from the block they were decoded into
+		template <bool Decoded>
+		Byte fetchOperandByte()
+		{
+			if constexpr ( Decoded )
+			{
+				tick();
+				return static_cast<Byte>( m_decodedOperand );
+			}
+			else
+				return readByteTick( m_programCounter++ );
+		}
+
+		template <bool Decoded>
+		Word fetchOperandWord()
+		{
+			if constexpr ( Decoded )
+			{
+				tick();
+				tick();
+				return m_decodedOperand;
+			}
+			else
+			{
+				Word word = readWordTick( m_programCounter );
+				m_programCounter += 2;
+				return word;
+			}
+		}
+
 		Word readWordTickBug( Word address )
 		{
 			Word low = readByteTick( address );
@@ -196,13 +338,13 @@ namespace nes
 
 		void conditionalBranch( bool branch );
 
-		template <AddressMode>
+		template <AddressMode, bool Decoded = false>
 		Word getAddress();
 
-		template <AddressMode Mode>
+		template <AddressMode Mode, bool Decoded = false>
 		void compareWithValue( Byte reg )
 		{
-			Byte value = readByteTick( getAddress<Mode>() );
+			Byte value = readByteTick( getAddress<Mode, Decoded>() );
 			setStatus( Carry, reg >= value );
 			setArithmeticFlags( reg - value );
 		}
@@ -213,7 +355,7 @@ namespace nes
 
 		// operations:
 
-		#define DEF_ADDRMODE_OP( name ) template <AddressMode Mode> void name();
+		#define DEF_ADDRMODE_OP( name ) template <AddressMode Mode, bool Decoded = false> void name();
 
 		DEF_ADDRMODE_OP( addWithCarry )
 		DEF_ADDRMODE_OP( bitwiseAnd )
@@ -306,9 +448,15 @@ namespace nes
 		Cartridge* m_cartridge = nullptr;
 		Controller* m_controllerPorts[ 2 ]{ nullptr, nullptr };
 
+		// direct pointers for readable memory, null pages go through the I/O handlers
+		const Byte* m_readPages[ NumPages ]{};
+
 		int m_cycles = 0;
-		int m_nmi = -1;
-		int m_irq = -1;
+
+		// PPU dots elapsed, the PPU runs lazily up to this clock
+		int64_t m_masterClock = 0;
+		int64_t m_nmiTime = -1;
+		int64_t m_irqTime = -1;
 
 		Word m_programCounter = 0;
 
@@ -322,6 +470,36 @@ namespace nes
 
 		bool m_oddCycle = false;
 		bool m_halt = false;
+
+		// the most recent backward jump in ROM
+		struct IdleLoop
+		{
+			Word head = 0;
+			Word end = 0;
+			const Byte* page = nullptr;
+
+			// the body only reads ram, rom or the PPU status
+			bool idle = false;
+			bool readsStatus = false;
+
+			// state at the last arrival at the head, -1 clock if the loop was left since
+			int64_t clock = -1;
+			Byte accumulator = 0;
+			Byte xRegister = 0;
+			Byte yRegister = 0;
+			Byte stackPointer = 0;
+			Byte status = 0;
+		};
+
+		IdleLoop m_idleLoop;
+		bool m_idleLoopSkipping = true;
+
+		std::vector<Block> m_blocks;
+		Word m_decodedOperand = 0;
+
+		// bit per internal ram page holding decoded code, and a count of the writes that dropped it
+		Byte m_ramCodePages = 0;
+		uint32_t m_ramVersions[ NumRamPages ]{};
 	};
 }
 
@@ -6,4 +6,9 @@
 
 uint32_t crc32(const unsigned char* data, size_t size);
 
-#endif
\ No newline at end of file
+// streaming form for data that arrives in pieces, crc32Final( crc32Update( crc32Init(), data, size ) ) == crc32( data, size )
+uint32_t crc32Init();
+uint32_t crc32Update(uint32_t crc, const unsigned char* data, size_t size);
+uint32_t crc32Final(uint32_t crc);
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef GLOBALS_HPP
 #define GLOBALS_HPP
 
+#include <atomic>
 #include <string>
 
 #include "SDL.h"
@@ -10,6 +11,8 @@
 #include "joypad.hpp"
 #include "zapper.hpp"
 #include "Nes.hpp"
+#include "RewindBuffer.hpp"
+#include "AudioRing.hpp"
 
 constexpr int DefaultCrop = 8;
 constexpr int MaxCrop = 8;
@@ -22,10 +25,15 @@ extern SDL_Renderer* renderer;
 extern nes::Joypad joypad[ 4 ];
 extern nes::Zapper zapper;
 extern nes::Nes s_nes;
-extern bool paused;
+extern std::atomic<bool> paused;
 extern bool step_frame;
 extern bool in_menu;
 extern bool muted;
+extern nes::RewindBuffer rewind_buffer;
+extern bool rewinding;
+extern bool fast_forward;
+extern int fast_forward_speed;
+extern nes::AudioRing audio_ring;
 
 // paths
 extern fs::path rom_filename;
@@ -50,11 +58,7 @@ extern SDL_Rect render_area;
 extern SDL_Rect crop_area;
 
 // frame timing
-extern const unsigned int TARGET_FPS;
-extern const float TIME_PER_FRAME;
-extern int last_time;
-extern int last_render_time;
-extern float last_wait_time;
+extern bool audio_rate_control;
 
 // frame rate
 extern int frame_number;
@@ -64,6 +68,7 @@ extern float real_fps;
 extern float total_real_fps;
 
 void resetFrameNumber();
+void updateFramePacing();
 void reset();
 void power();
 bool loadFile(std::string filename);
@@ -9,6 +9,7 @@ typedef void(*Callback)(void);
 struct Hotkey {
 	SDL_Keycode key;
 	Callback callback;
+	Callback release = nullptr;
 };
 
 extern std::vector<Hotkey> hotkeys;
@@ -48,11 +49,18 @@ void loadMovie();
 
 void takeScreenshot();
 
+void startRewind();
+void stopRewind();
+
+void startFastForward();
+void stopFastForward();
+
 void saveState();
 void saveState(const std::string& filename);
 void loadState();
 void loadState(const std::string& filename);
 
 void pressHotkey(SDL_Keycode key);
+void releaseHotkey(SDL_Keycode key);
 
 #endif
\ No newline at end of file
@@ -28,6 +28,9 @@ namespace nes
 		Joypad();
 		~Joypad() override = default;
 
+		// the button mapped to key without changing its state
+		Button getKeyButton( int key ) const;
+
 		Button setKeyState( int key, bool pressed );
 		Button pressKey( int key );
 		Button releaseKey( int key );
@@ -8,7 +8,7 @@
 namespace nes
 {
 
-class Mapper1 : public Cartridge
+class Mapper1 final : public Cartridge
 {
 public:
 	Mapper1( Memory data );
@@ -36,7 +36,7 @@ private:
 	static constexpr Byte SHIFT_REG_INIT = 0x10;
 
 	Byte m_shiftRegister;
-	Byte m_registers[ NUM_REGISTERS ];
+	Byte m_registers[ NUM_REGISTERS ]{};
 
 	void applyBankSwitch();
 	int getMirrorMode();
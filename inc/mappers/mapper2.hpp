@@ -6,7 +6,7 @@
 namespace nes
 {
 
-class Mapper2 : public Cartridge
+class Mapper2 final : public Cartridge
 {
 public:
 	Mapper2( Memory data );
@@ -6,7 +6,7 @@
 namespace nes
 {
 
-class Mapper3 : public Cartridge
+class Mapper3 final : public Cartridge
 {
 public:
 	using Cartridge::Cartridge;
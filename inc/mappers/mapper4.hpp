@@ -7,11 +7,12 @@
 namespace nes
 {
 
-class Mapper4 : public Cartridge
+class Mapper4 final : public Cartridge
 {
 public:
 	Mapper4( Memory data ) : Cartridge( std::move( data ) )
 	{
+		setPpuEvents( ScanlineSignal );
 		reset();
 	}
 
@@ -21,11 +22,6 @@ public:
 
 	void signalScanline() override;
 
-	void setCPU( Cpu& cpu ) override
-	{
-		m_cpu = &cpu;
-	}
-
 	void saveState( ByteIO::Writer& writer ) override;
 	void loadState( ByteIO::Reader& reader ) override;
 
@@ -54,9 +50,7 @@ private:
 		NUM_REGISTERS = 8
 	};
 
-	nes::Cpu* m_cpu = nullptr;
-
-	Byte m_bankRegisters[ NUM_REGISTERS ];
+	Byte m_bankRegisters[ NUM_REGISTERS ]{};
 	
 	Byte m_bankSelect = 0;
 	Byte m_irqLatch = 0;
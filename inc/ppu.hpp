@@ -1,13 +1,19 @@
 #ifndef NES_PPU_HPP
 #define NES_PPU_HPP
 
-#include "Pixel.hpp"
+#include "pixel.hpp"
 #include "ppu_defs.hpp"
 #include "Ram.hpp"
 #include "types.hpp"
 
 #include <iostream>
 
+namespace ByteIO
+{
+	class Writer;
+	class Reader;
+}
+
 namespace nes
 {
 	class Cartridge;
@@ -24,17 +30,33 @@ namespace nes
 			m_cpu = &cpu;
 		}
 
-		void setCartridge( Cartridge* cartridge )
-		{
-			m_cartridge = cartridge;
-		}
+		// registers the cartridge's PPU events
+		void setCartridge( Cartridge* cartridge );
 
 		void power();
 		void reset();
 
-		bool readyToDraw();
+		// true once per finished frame
+		bool readyToDraw()
+		{
+			if ( !m_canDraw )
+				return false;
 
-		void tick();
+			m_canDraw = false;
+			return true;
+		}
+
+		// run until the PPU clock catches up to the CPU
+		void runTo( int64_t clock );
+
+		int64_t getClock() const { return m_clock; }
+		void setClock( int64_t clock );
+
+		// clock when the PPU may next raise an interrupt or finish a frame
+		int64_t getNextEventClock() const { return m_nextEventClock; }
+
+		// clock until which reading the status register gives the same value, the PPU must be synced
+		int64_t getStatusStableClock() const;
 
 		Byte readRegister( size_t reg );
 		void writeRegister( size_t reg, Byte value );
@@ -44,7 +66,7 @@ namespace nes
 			m_primaryOAM[ m_oamAddress++ ] = value;
 		}
 
-		bool renderingEnabled()
+		bool renderingEnabled() const
 		{
 			return m_mask & ( ShowBackground | ShowSprite );
 		}
@@ -57,14 +79,31 @@ namespace nes
 		bool getSpriteFlickering() const { return m_spriteFlickering; }
 		void setSpriteFlickering( bool flicker ) { m_spriteFlickering = flicker; }
 
-		void saveState( std::ostream& out ) const;
-		void loadState( std::istream& in );
+		// when off the frame buffer keeps the last drawn frame, timing and status flags stay exact
+		// pixels are only composed on scanlines where sprite 0 can still hit, set it between frames
+		bool getRenderOutput() const { return m_renderOutput; }
+		void setRenderOutput( bool on ) { m_renderOutput = on; }
+
+		// cpu alignment applied on power and reset, 0-3 or ClockSyncRandom
+		int getClockSyncAlignment() const { return m_clockSyncAlignment; }
+		void setClockSyncAlignment( int alignment ) { m_clockSyncAlignment = alignment; }
 
-		const Pixel* getPixelBuffer() const
+		static constexpr int ClockSyncRandom = -1;
+
+		void saveState( ByteIO::Writer& writer ) const;
+		void loadState( ByteIO::Reader& reader );
+
+		// palette indices of the frame being drawn
+		const Byte* getFrameBuffer() const
 		{
-			return m_pixels;
+			return m_frameBuffer;
 		}
 
+		static Pixel getColour( Byte index );
+
+		// convert a frame of palette indices to RGB
+		static void convertFrame( const Byte* frame, Pixel* pixels );
+
 		static constexpr size_t ScreenWidth = 256;
 		static constexpr size_t ScreenHeight = 240;
 
@@ -95,6 +134,14 @@ namespace nes
 			FlipVertically = 1 << 7
 		};
 
+		// sprite line buffer entries
+		enum SpriteLinePixel : Byte
+		{
+			SpriteLinePalette = 0x1f,
+			SpriteLineBehind = 1 << 6,
+			SpriteLineFirst = 1 << 7 // pixel comes from the first sprite in secondary OAM
+		};
+
 		static constexpr size_t NAMETABLE_SIZE = 0x0800;
 		static constexpr size_t PALETTE_SIZE = 0x0020;
 		static constexpr size_t PRIMARY_OAM_SIZE = 64;
@@ -102,6 +149,12 @@ namespace nes
 
 	private:
 
+		void tick();
+		void updateNextEvent();
+		int getIdleDots() const;
+		int getDotsUntilScanlineSignal() const;
+		void updateScanlineSignal();
+
 		void clearScreen();
 		void randomizeClockSync();
 		void clearOAM();
@@ -120,8 +173,12 @@ namespace nes
 		void updateVRAMY();
 		void renderPixel();
 		void renderPixelInternal();
+		void drawPixel( int x, Byte palette );
+		void renderBackgroundSpan();
+		void fetchAttribute();
 		void loadSpritesOnScanline();
 		void loadSpriteRegisters();
+		void buildSpriteLine();
 		void loadShiftRegisters();
 		void incrementXComponent();
 		void incrementYComponent();
@@ -146,13 +203,17 @@ namespace nes
 		Cpu* m_cpu = nullptr;
 		Cartridge* m_cartridge = nullptr;
 
+		int64_t m_clock = 0;
+		int64_t m_nextEventClock = 0;
+		int64_t m_scanlineSignalClock = 0;
+
 		uint32_t m_frame = 0;
 		uint32_t m_cycle = 0;
 		uint32_t m_scanline = 0;
 		uint32_t m_spritesOnNextScanline = 0;
 		uint32_t m_spritesOnThisScanline = 0;
 
-		Pixel m_pixels[ ScreenWidth * ScreenHeight ];
+		Byte m_frameBuffer[ ScreenWidth * ScreenHeight ];
 
 		Word m_renderAddress = 0;
 		Word m_vramAddress = 0;
@@ -169,6 +230,12 @@ namespace nes
 		Ram<PRIMARY_OAM_SIZE, false> m_spriteXCounter;
 		Ram<PRIMARY_OAM_SIZE, false> m_spriteAttributeLatch;
 
+		// decoded sprite rows with horizontal flip applied
+		uint64_t m_spritePixels[ PRIMARY_OAM_SIZE ]{};
+
+		// front-most sprite pixel for each x on the current scanline, padded for sprites past the right edge
+		Byte m_spriteLine[ ScreenWidth + 8 ]{};
+
 		Byte m_openBus = 0;
 		Byte m_readBuffer = 0;
 		Byte m_control = 0;
@@ -183,8 +250,12 @@ namespace nes
 		Byte m_attributeShiftHigh = 0;
 		Byte m_nametableLatch = 0;
 
+		int m_clockSyncAlignment = ClockSyncRandom;
+
 		bool m_canDraw = false;
 		bool m_spriteFlickering = true;
+		bool m_renderOutput = true;
+		bool m_scanlineSignal = false;
 		bool m_writeToggle = false;
 		bool m_supressVBlank = false;
 		bool m_attributeLatchLow = false;
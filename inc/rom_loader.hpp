@@ -2,6 +2,7 @@
 #define ROM_LOADER_HPP
 
 #include <memory>
+#include <stdexcept>
 
 namespace nes
 {
@@ -11,7 +12,15 @@ class Cartridge;
 namespace Rom
 {
 
-std::unique_ptr<Cartridge> load( const char* filename );
+class LoadError : public std::runtime_error
+{
+	using std::runtime_error::runtime_error;
+};
+
+// throws LoadError if the file is not a supported ROM
+// shared maps the file read only and shares it with other cartridges loaded from it, for running many instances
+// the file must then not be rewritten while it is loaded, otherwise it is copied into memory
+std::unique_ptr<Cartridge> load( const char* filename, bool shared = false );
 
 }
 }
@@ -3,7 +3,7 @@
 
 #include "controller.hpp"
 
-#include "Pixel.hpp"
+#include "ppu.hpp"
 
 namespace nes
 {
@@ -12,7 +12,7 @@ namespace nes
 	{
 	public:
 
-		Zapper( const Pixel* screen ) : m_screen( screen ) {}
+		Zapper( const Byte* screen ) : m_screen( screen ) {}
 
 		Byte read() override
 		{
@@ -44,7 +44,7 @@ namespace nes
 		{
 			if ( m_x >= 0 && m_x < 256 && m_y >= 0 && m_y < 240 )
 			{
-				Pixel p = m_screen[ m_x + m_y * 256 ];
+				Pixel p = Ppu::getColour( m_screen[ m_x + m_y * 256 ] );
 				return ( p.r >= 0xf8 ) && ( p.g >= 0xf8 ) && ( p.b >= 0xf8 );
 			}
 
@@ -57,7 +57,7 @@ namespace nes
 			m_y = y;
 		}
 
-		void setScreenBuffer( const Pixel* screen )
+		void setScreenBuffer( const Byte* screen )
 		{
 			m_screen = screen;
 		}
@@ -68,7 +68,7 @@ namespace nes
 		int m_x = 0;
 		int m_y = 0;
 
-		const Pixel* m_screen = nullptr;
+		const Byte* m_screen = nullptr;
 	};
 
 }
@@ -74,6 +74,11 @@ public:
 	enum { osc_count = 5 };
 	void osc_output( int index, Blip_Buffer* buffer );
 	
+	// Get/set amplitude an oscillator last output. Restoring the amplitude
+	// after load_snapshot() continues the current output without a click.
+	int osc_amp( int index ) const;
+	void set_osc_amp( int index, int amp );
+	
 	// Set IRQ time callback that is invoked when the time of earliest IRQ
 	// may have changed, or NULL to disable. When callback is invoked,
 	// 'user_data' is passed unchanged as the first parameter.
@@ -136,6 +141,18 @@ inline void Nes_Apu::osc_output( int osc, Blip_Buffer* buf )
 	oscs [osc]->output = buf;
 }
 
+inline int Nes_Apu::osc_amp( int osc ) const
+{
+	assert(( "Nes_Apu::osc_amp(): Index out of range", 0 <= osc && osc < osc_count ));
+	return oscs [osc]->last_amp;
+}
+
+inline void Nes_Apu::set_osc_amp( int osc, int amp )
+{
+	assert(( "Nes_Apu::set_osc_amp(): Index out of range", 0 <= osc && osc < osc_count ));
+	oscs [osc]->last_amp = amp;
+}
+
 inline cpu_time_t Nes_Apu::earliest_irq() const
 {
 	return earliest_irq_;
@@ -119,6 +119,7 @@
 	#define STD
 #endif
 
+#include <climits>
 #include <cstdint>
 
 // BOOST_STATIC_ASSERT( expr )
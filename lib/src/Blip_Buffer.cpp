@@ -45,7 +45,7 @@ void Blip_Buffer::clear( bool entire_buffer )
 
 blargg_err_t Blip_Buffer::sample_rate( long new_rate, int msec )
 {
-	unsigned new_size = (std::numeric_limits<unsigned long>::max() >> BLIP_BUFFER_ACCURACY) + 1 - widest_impulse_ - 64;
+	unsigned new_size = (std::numeric_limits<unsigned int>::max() >> BLIP_BUFFER_ACCURACY) + 1 - widest_impulse_ - 64;
 	if ( msec != blip_default_length )
 	{
 		size_t s = (new_rate * (msec + 1) + 999) / 1000;
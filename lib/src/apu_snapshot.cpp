@@ -43,6 +43,7 @@ struct apu_reflection
 	{
 		REFLECT( state.delay,           osc.delay );
 		REFLECT( state.length,          osc.length_counter );
+		REFLECT( state.phase,           osc.phase );
 		REFLECT( state.linear_counter,  osc.linear_counter );
 		REFLECT( state.linear_mode,     osc.reg_written [3] );
 	}
@@ -120,5 +121,8 @@ void Nes_Apu::load_snapshot( apu_snapshot_t const& state )
 	refl::reflect_dmc     ( st.dmc,         dmc );
 	dmc.recalc_irq();
 	dmc.last_amp = dmc.dac;
+	
+	// writing $4015 above started the DMC with cleared registers, which drops its enable
+	osc_enables = state.w4015;
 }
 
@@ -0,0 +1,106 @@
+#include "AudioRing.hpp"
+
+#include <stdx/assert.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace nes;
+
+namespace
+{
+	size_t roundUpToPowerOfTwo( size_t value )
+	{
+		size_t result = 1;
+		while ( result < value )
+			result <<= 1;
+		return result;
+	}
+}
+
+AudioRing::AudioRing( size_t capacity )
+{
+	setCapacity( capacity );
+}
+
+void AudioRing::setCapacity( size_t capacity )
+{
+	m_buffer.assign( roundUpToPowerOfTwo( std::max<size_t>( capacity, 1 ) ), 0 );
+	m_mask = m_buffer.size() - 1;
+	clear();
+}
+
+void AudioRing::setLatencyTarget( size_t samples )
+{
+	m_latencyTarget.store( samples, std::memory_order_relaxed );
+}
+
+size_t AudioRing::write( const blip_sample_t* samples, size_t count )
+{
+	const size_t writePosition = m_writePosition.load( std::memory_order_relaxed );
+	const size_t readPosition = m_readPosition.load( std::memory_order_acquire );
+
+	const size_t space = m_buffer.size() - ( writePosition - readPosition );
+	if ( count > space )
+	{
+		m_overruns.fetch_add( 1, std::memory_order_relaxed );
+		count = space;
+	}
+
+	// copy in up to two pieces around the end of the buffer
+	const size_t offset = writePosition & m_mask;
+	const size_t first = std::min( count, m_buffer.size() - offset );
+	std::memcpy( &m_buffer[ offset ], samples, first * sizeof( blip_sample_t ) );
+	std::memcpy( &m_buffer[ 0 ], samples + first, ( count - first ) * sizeof( blip_sample_t ) );
+
+	m_writePosition.store( writePosition + count, std::memory_order_release );
+	return count;
+}
+
+void AudioRing::read( blip_sample_t* out, size_t count )
+{
+	const size_t readPosition = m_readPosition.load( std::memory_order_relaxed );
+	const size_t writePosition = m_writePosition.load( std::memory_order_acquire );
+
+	size_t available = writePosition - readPosition;
+	if ( m_filling )
+	{
+		// hold back until there is enough queued to ride out the producer's jitter
+		if ( available < std::min( getLatencyTarget(), m_buffer.size() ) )
+			available = 0;
+		else
+			m_filling = false;
+	}
+	else if ( available < count )
+	{
+		m_underruns.fetch_add( 1, std::memory_order_relaxed );
+		m_filling = true;
+	}
+
+	const size_t n = std::min( count, available );
+	const size_t offset = readPosition & m_mask;
+	const size_t first = std::min( n, m_buffer.size() - offset );
+	std::memcpy( out, &m_buffer[ offset ], first * sizeof( blip_sample_t ) );
+	std::memcpy( out + first, &m_buffer[ 0 ], ( n - first ) * sizeof( blip_sample_t ) );
+	std::fill( out + n, out + count, blip_sample_t( 0 ) );
+
+	m_readPosition.store( readPosition + n, std::memory_order_release );
+}
+
+size_t AudioRing::size() const
+{
+	// load the read position first so the write position can't be behind it
+	const size_t readPosition = m_readPosition.load( std::memory_order_acquire );
+	const size_t writePosition = m_writePosition.load( std::memory_order_acquire );
+
+	return std::min( writePosition - readPosition, m_buffer.size() );
+}
+
+void AudioRing::clear()
+{
+	m_writePosition.store( 0, std::memory_order_relaxed );
+	m_readPosition.store( 0, std::memory_order_relaxed );
+	m_underruns.store( 0, std::memory_order_relaxed );
+	m_overruns.store( 0, std::memory_order_relaxed );
+	m_filling = true;
+}
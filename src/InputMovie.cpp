@@ -0,0 +1,108 @@
+#include "InputMovie.hpp"
+
+#include <stdx/assert.h>
+#include "common.hpp"
+
+#include <fstream>
+
+using namespace nes;
+
+void InputMovie::clear()
+{
+	m_buttonPresses.clear();
+	m_index = 0;
+	m_checksum = 0;
+}
+
+bool InputMovie::save( const std::string& filename, uint32_t checksum ) const
+{
+	std::ofstream fout( filename.c_str(), std::ios::binary );
+	if ( !fout.is_open() )
+	{
+		dbLogError( "cannot save movie to %s", filename.c_str() );
+		return false;
+	}
+
+	writeBinary( fout, checksum );
+
+	int size = static_cast<int>( m_buttonPresses.size() );
+	writeBinary( fout, size );
+
+	for ( const ButtonPress& press : m_buttonPresses )
+	{
+		writeBinary( fout, press );
+	}
+
+	return true;
+}
+
+bool InputMovie::load( const std::string& filename )
+{
+	std::ifstream fin( filename.c_str(), std::ios::binary );
+	if ( !fin.is_open() )
+	{
+		dbLogError( "cannot open movie from %s", filename.c_str() );
+		return false;
+	}
+
+	clear();
+
+	int size = 0;
+	readBinary( fin, m_checksum );
+	readBinary( fin, size );
+
+	for ( int i = 0; i < size && fin; i++ )
+	{
+		ButtonPress press;
+		readBinary( fin, press );
+		m_buttonPresses.push_back( press );
+	}
+
+	if ( !fin || size < 0 )
+	{
+		dbLogError( "movie %s is truncated", filename.c_str() );
+		clear();
+		return false;
+	}
+
+	return true;
+}
+
+void InputMovie::record( int frame, int joypad, Joypad::Button button, bool pressed )
+{
+	m_buttonPresses.push_back( { frame, joypad, button, pressed } );
+}
+
+bool InputMovie::updateInput( int frame, Joypad* joypads, size_t numJoypads )
+{
+	while ( m_index < m_buttonPresses.size() )
+	{
+		const ButtonPress& press = m_buttonPresses[ m_index ];
+		if ( press.frame < frame )
+		{
+			m_index++;
+		}
+		else if ( press.frame == frame )
+		{
+			// presses come from a file so ignore any that don't name a button
+			const bool valid = ( 0 <= press.joypad && press.joypad < static_cast<int>( numJoypads ) )
+				&& ( 0 <= press.button && press.button < Joypad::NUM_BUTTONS );
+
+			if ( valid )
+				joypads[ press.joypad ].setButtonState( press.button, press.pressed );
+
+			m_index++;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	return m_index < m_buttonPresses.size();
+}
+
+int InputMovie::getLastFrame() const
+{
+	return m_buttonPresses.empty() ? -1 : m_buttonPresses.back().frame;
+}
@@ -0,0 +1,40 @@
+#include "InputQueue.hpp"
+
+using namespace nes;
+
+static_assert( ( InputQueue::Capacity & ( InputQueue::Capacity - 1 ) ) == 0, "capacity must be a power of two" );
+
+bool InputQueue::push( const InputEvent& event )
+{
+	const size_t writePosition = m_writePosition.load( std::memory_order_relaxed );
+	const size_t readPosition = m_readPosition.load( std::memory_order_acquire );
+
+	if ( writePosition - readPosition == Capacity )
+		return false;
+
+	m_events[ writePosition & ( Capacity - 1 ) ] = event;
+	m_writePosition.store( writePosition + 1, std::memory_order_release );
+	return true;
+}
+
+bool InputQueue::pop( InputEvent& event, InputEvent::Clock::time_point time )
+{
+	const size_t readPosition = m_readPosition.load( std::memory_order_relaxed );
+	const size_t writePosition = m_writePosition.load( std::memory_order_acquire );
+
+	if ( readPosition == writePosition )
+		return false;
+
+	const InputEvent& next = m_events[ readPosition & ( Capacity - 1 ) ];
+	if ( next.time > time )
+		return false;
+
+	event = next;
+	m_readPosition.store( readPosition + 1, std::memory_order_release );
+	return true;
+}
+
+void InputQueue::clear()
+{
+	m_readPosition.store( m_writePosition.load( std::memory_order_acquire ), std::memory_order_release );
+}
@@ -0,0 +1,169 @@
+#include "Memory.hpp"
+
+#include <sys/stat.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+namespace nes
+{
+
+	// a whole file mapped read only, along with data computed from it
+	class FileMapping
+	{
+	public:
+
+		FileMapping( const char* filename, size_t size )
+		{
+#ifdef _WIN32
+			HANDLE file = CreateFileA( filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+			if ( file == INVALID_HANDLE_VALUE )
+				return;
+
+			// the view keeps the mapping open after the handles are closed
+			HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+			if ( mapping )
+			{
+				m_data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, size );
+				CloseHandle( mapping );
+			}
+			CloseHandle( file );
+#else
+			const int file = open( filename, O_RDONLY );
+			if ( file < 0 )
+				return;
+
+			// truncating the file while it is mapped faults the next read of it
+			void* data = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, file, 0 );
+			if ( data != MAP_FAILED )
+				m_data = data;
+			close( file );
+#endif
+			if ( m_data )
+				m_size = size;
+		}
+
+		FileMapping( const FileMapping& ) = delete;
+		FileMapping& operator=( const FileMapping& ) = delete;
+
+		~FileMapping()
+		{
+			if ( !m_data )
+				return;
+#ifdef _WIN32
+			UnmapViewOfFile( m_data );
+#else
+			munmap( m_data, m_size );
+#endif
+		}
+
+		Byte* data() const { return static_cast<Byte*>( m_data ); }
+		size_t size() const { return m_size; }
+
+		std::shared_ptr<const void> getShared( std::type_index type, const std::function<std::shared_ptr<const void>()>& build )
+		{
+			std::lock_guard<std::mutex> lock( m_sharedMutex );
+
+			auto& shared = m_shared[ type ];
+			if ( !shared )
+				shared = build();
+			return shared;
+		}
+
+	private:
+
+		void* m_data = nullptr;
+		size_t m_size = 0;
+
+		std::mutex m_sharedMutex;
+		std::map<std::type_index, std::shared_ptr<const void>> m_shared;
+	};
+
+}
+
+using namespace nes;
+
+namespace
+{
+	// identifies a version of a file, a rewritten ROM must not reuse the old mapping
+	struct FileVersion
+	{
+		size_t size = 0;
+		time_t modified = 0;
+
+		bool operator==( const FileVersion& other ) const
+		{
+			return size == other.size && modified == other.modified;
+		}
+	};
+
+	bool getFileVersion( const char* filename, FileVersion& version )
+	{
+		struct stat info;
+		if ( stat( filename, &info ) != 0 || ( info.st_mode & S_IFMT ) != S_IFREG )
+			return false;
+
+		version.size = static_cast<size_t>( info.st_size );
+		version.modified = info.st_mtime;
+		return true;
+	}
+
+	struct CachedMapping
+	{
+		FileVersion version;
+		std::weak_ptr<FileMapping> mapping;
+	};
+
+	// mappings stay alive only as long as some Memory uses them
+	std::mutex s_mappingsMutex;
+	std::map<std::string, CachedMapping> s_mappings;
+}
+
+Memory Memory::mapFile( const char* filename )
+{
+	FileVersion version;
+	if ( !getFileVersion( filename, version ) || version.size == 0 )
+		return Memory();
+
+	std::lock_guard<std::mutex> lock( s_mappingsMutex );
+
+	// forget files whose mappings were released so the table only holds live ones
+	for ( auto it = s_mappings.begin(); it != s_mappings.end(); )
+		it = it->second.mapping.expired() ? s_mappings.erase( it ) : std::next( it );
+
+	CachedMapping& cached = s_mappings[ filename ];
+	std::shared_ptr<FileMapping> mapping = cached.mapping.lock();
+	if ( !mapping || !( cached.version == version ) )
+	{
+		mapping = std::make_shared<FileMapping>( filename, version.size );
+		if ( !mapping->data() )
+		{
+			s_mappings.erase( filename );
+			return Memory();
+		}
+
+		cached.version = version;
+		cached.mapping = mapping;
+	}
+
+	Memory memory;
+	memory.m_data = mapping->data();
+	memory.m_size = mapping->size();
+	memory.m_mapping = std::move( mapping );
+	return memory;
+}
+
+std::shared_ptr<const void> Memory::getShared( std::type_index type, const std::function<std::shared_ptr<const void>()>& build ) const
+{
+	dbAssert( m_mapping );
+	return m_mapping->getShared( type, build );
+}
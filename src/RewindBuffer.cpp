@@ -0,0 +1,244 @@
+#include "RewindBuffer.hpp"
+
+#include "Nes.hpp"
+
+#include <cstring>
+
+using namespace nes;
+
+namespace
+{
+	void writeVarint( std::vector<Byte>& out, size_t value )
+	{
+		while ( value >= 0x80 )
+		{
+			out.push_back( static_cast<Byte>( value | 0x80 ) );
+			value >>= 7;
+		}
+		out.push_back( static_cast<Byte>( value ) );
+	}
+
+	size_t readVarint( const std::vector<Byte>& in, size_t& pos )
+	{
+		size_t value = 0;
+		for( int shift = 0;; shift += 7 )
+		{
+			const Byte b = in[ pos++ ];
+			value |= size_t( b & 0x7f ) << shift;
+			if ( ( b & 0x80 ) == 0 )
+				return value;
+		}
+	}
+}
+
+RewindBuffer::~RewindBuffer()
+{
+	if ( m_worker.joinable() )
+	{
+		{
+			std::lock_guard<std::mutex> lock( m_mutex );
+			m_quit = true;
+		}
+		m_wake.notify_one();
+		m_worker.join();
+	}
+}
+
+void RewindBuffer::setCapacity( size_t capacity )
+{
+	std::unique_lock<std::mutex> lock( m_mutex );
+	waitUntilIdle( lock );
+
+	m_capacity = capacity;
+	if ( m_capacity == 0 )
+	{
+		m_current.clear();
+		m_deltas.clear();
+		m_deltaBytes = 0;
+		m_currentLoaded = false;
+	}
+	else
+	{
+		evict();
+	}
+}
+
+void RewindBuffer::push( Nes& nes )
+{
+	if ( m_capacity == 0 )
+		return;
+
+	m_pushBuffer.resize( nes.getSnapshotSize() );
+	nes.saveSnapshot( m_pushBuffer.data(), m_pushBuffer.size() );
+
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		if ( !m_worker.joinable() )
+			m_worker = std::thread( &RewindBuffer::run, this );
+
+		m_pending.swap( m_pushBuffer );
+		m_hasPending = true;
+	}
+	m_wake.notify_one();
+}
+
+bool RewindBuffer::pop( Nes& nes )
+{
+	std::unique_lock<std::mutex> lock( m_mutex );
+	waitUntilIdle( lock );
+
+	if ( m_current.empty() )
+		return false;
+
+	if ( m_current.size() != nes.getSnapshotSize() )
+	{
+		// history belongs to another cartridge
+		m_current.clear();
+		m_deltas.clear();
+		m_deltaBytes = 0;
+		m_currentLoaded = false;
+		return false;
+	}
+
+	if ( m_currentLoaded )
+	{
+		if ( m_deltas.empty() )
+			return false;
+
+		applyDelta( m_deltas.back(), m_current );
+		m_deltaBytes -= m_deltas.back().size();
+		m_deltas.pop_back();
+	}
+
+	nes.loadSnapshot( m_current.data(), m_current.size() );
+	m_currentLoaded = true;
+
+	return true;
+}
+
+void RewindBuffer::clear()
+{
+	std::unique_lock<std::mutex> lock( m_mutex );
+	waitUntilIdle( lock );
+
+	m_current.clear();
+	m_deltas.clear();
+	m_deltaBytes = 0;
+	m_currentLoaded = false;
+}
+
+size_t RewindBuffer::size()
+{
+	std::unique_lock<std::mutex> lock( m_mutex );
+	waitUntilIdle( lock );
+
+	if ( m_current.empty() )
+		return 0;
+
+	return m_deltas.size() + ( m_currentLoaded ? 0 : 1 );
+}
+
+void RewindBuffer::run()
+{
+	std::vector<Byte> state;
+
+	std::unique_lock<std::mutex> lock( m_mutex );
+	while ( true )
+	{
+		m_wake.wait( lock, [this]{ return m_hasPending || m_quit; } );
+		if ( m_quit )
+			return;
+
+		state.swap( m_pending );
+		m_hasPending = false;
+		m_busy = true;
+
+		// the history is only touched by the main thread once the worker is idle
+		lock.unlock();
+		addState( state );
+		lock.lock();
+
+		m_busy = false;
+		m_idle.notify_all();
+	}
+}
+
+void RewindBuffer::waitUntilIdle( std::unique_lock<std::mutex>& lock )
+{
+	m_idle.wait( lock, [this]{ return !m_hasPending && !m_busy; } );
+}
+
+void RewindBuffer::addState( std::vector<Byte>& state )
+{
+	if ( m_current.size() == state.size() )
+	{
+		std::vector<Byte> delta;
+		encodeDelta( m_current, state, delta );
+
+		m_deltaBytes += delta.size();
+		m_deltas.push_back( std::move( delta ) );
+	}
+	else
+	{
+		m_deltas.clear();
+		m_deltaBytes = 0;
+	}
+
+	m_current.swap( state );
+	m_currentLoaded = false;
+	evict();
+}
+
+void RewindBuffer::evict()
+{
+	// the newest snapshot is kept whole so it counts against the capacity too
+	while ( m_current.size() + m_deltaBytes > m_capacity && !m_deltas.empty() )
+	{
+		m_deltaBytes -= m_deltas.front().size();
+		m_deltas.pop_front();
+	}
+}
+
+// pairs of unchanged and changed byte counts, followed by the changed bytes XORed together
+void RewindBuffer::encodeDelta( const std::vector<Byte>& from, const std::vector<Byte>& to, std::vector<Byte>& delta )
+{
+	dbAssert( from.size() == to.size() );
+
+	const size_t size = from.size();
+	size_t i = 0;
+	while ( i < size )
+	{
+		const size_t sameStart = i;
+		while ( i + 8 <= size && std::memcmp( &from[ i ], &to[ i ], 8 ) == 0 )
+			i += 8;
+		while ( i < size && from[ i ] == to[ i ] )
+			++i;
+
+		const size_t changedStart = i;
+		while ( i < size && from[ i ] != to[ i ] )
+			++i;
+
+		writeVarint( delta, changedStart - sameStart );
+		writeVarint( delta, i - changedStart );
+		for( size_t j = changedStart; j < i; ++j )
+			delta.push_back( from[ j ] ^ to[ j ] );
+	}
+}
+
+void RewindBuffer::applyDelta( const std::vector<Byte>& delta, std::vector<Byte>& state )
+{
+	size_t pos = 0;
+	size_t offset = 0;
+	while ( pos < delta.size() )
+	{
+		offset += readVarint( delta, pos );
+		const size_t changed = readVarint( delta, pos );
+
+		dbAssert( offset + changed <= state.size() );
+		for( size_t j = 0; j < changed; ++j )
+			state[ offset + j ] ^= delta[ pos + j ];
+
+		pos += changed;
+		offset += changed;
+	}
+}
@@ -1,6 +1,7 @@
-#include "Apu.hpp"
+#include "apu.hpp"
 
 #include "ByteIO.hpp"
+#include <stdx/assert.h>
 
 #include "apu_snapshot.h"
 
@@ -15,18 +16,50 @@ namespace
 
 Apu::Apu()
 {
-    constexpr int SampleRate = 48000;
-
     m_buffer.sample_rate( SampleRate );
-    m_buffer.clock_rate( 1789773 );
+    m_buffer.clock_rate( ClockRate );
+    m_hiddenBuffer.sample_rate( SampleRate );
+    m_hiddenBuffer.clock_rate( ClockRate );
     m_apu.output( &m_buffer );
-    m_soundQueue.init( SampleRate );
 }
 
 void Apu::setMute( bool mute )
 {
     m_muted = mute;
-    m_apu.output( mute ? nullptr : &m_buffer );
+    updateOutput();
+}
+
+void Apu::setOutputSuppressed( bool suppress )
+{
+    if ( suppress )
+    {
+        if ( m_suppressDepth++ > 0 )
+            return;
+
+        for ( int i = 0; i < Nes_Apu::osc_count; ++i )
+            m_oscAmps[ i ] = m_apu.osc_amp( i );
+    }
+    else
+    {
+        dbAssert( m_suppressDepth > 0 );
+        if ( --m_suppressDepth > 0 )
+            return;
+
+        // continue from the level the shown frames left in the buffer
+        for ( int i = 0; i < Nes_Apu::osc_count; ++i )
+            m_apu.set_osc_amp( i, m_oscAmps[ i ] );
+    }
+
+    updateOutput();
+}
+
+void Apu::updateOutput()
+{
+    // hidden frames still need an output, a null buffer stops DMC sample fetches
+    if ( m_muted )
+        m_apu.output( nullptr );
+    else
+        m_apu.output( m_suppressDepth > 0 ? &m_hiddenBuffer : &m_buffer );
 }
 
 void Apu::setDmcReader( dmc_reader_t func )
@@ -34,6 +67,17 @@ void Apu::setDmcReader( dmc_reader_t func )
     m_apu.dmc_reader( std::move( func ) );
 }
 
+void Apu::setSampleOutput( SampleOutput output )
+{
+    m_sampleOutput = std::move( output );
+}
+
+void Apu::setClockRateScale( double scale )
+{
+    // hidden frames are discarded so only the shown buffer follows the scale
+    m_buffer.clock_rate( static_cast<long>( ClockRate * scale + 0.5 ) );
+}
+
 void Apu::reset()
 {
     m_apu.reset();
@@ -58,16 +102,28 @@ void Apu::write( cpu_time_t elapsedCycles, Word address, Byte value )
 void Apu::runFrame( cpu_time_t elapsedCycles )
 {
     m_apu.end_frame( elapsedCycles );
+
+    if ( m_suppressDepth > 0 )
+    {
+        m_hiddenBuffer.end_frame( elapsedCycles );
+        m_hiddenBuffer.clear();
+        return;
+    }
+
     m_buffer.end_frame( elapsedCycles );
 
-    if ( m_muted )
+    if ( m_muted || !m_sampleOutput )
     {
         m_buffer.clear();
     }
-    else if ( (size_t)m_buffer.samples_avail() >= OutBufferSize )
+    else
     {
-        size_t samples = m_buffer.read_samples( m_outBuf, OutBufferSize );
-        m_soundQueue.write( m_outBuf, (int)samples );
+        // hand over every frame, the output does its own buffering
+        while ( m_buffer.samples_avail() > 0 )
+        {
+            size_t samples = m_buffer.read_samples( m_outBuf, OutBufferSize );
+            m_sampleOutput( m_outBuf, samples );
+        }
     }
 }
 
@@ -75,12 +131,11 @@ void Apu::saveState( ByteIO::Writer& writer ) const
 {
     writer.write( s_header );
 
-    apu_snapshot_t apuState;
+    // zeroed so padding doesn't leave garbage in the state
+    apu_snapshot_t apuState{};
     m_apu.save_snapshot( &apuState );
 
     writer.write( apuState );
-    writer.write( m_outBuf );
-    writer.write( m_muted );
 }
 
 void Apu::loadState( ByteIO::Reader& reader )
@@ -90,8 +145,6 @@ void Apu::loadState( ByteIO::Reader& reader )
     apu_snapshot_t apuState;
 
     reader.read( apuState );
-    reader.read( m_outBuf );
-    reader.read( m_muted );
 
     m_apu.load_snapshot( apuState );
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
-#include "Cartridge.hpp"
+#include "cartridge.hpp"
 
+#include "cpu.hpp"
 #include "crc32.hpp"
 #include <stdx/assert.h>
 #include "Header.hpp"
@@ -43,8 +44,24 @@ Cartridge::Cartridge( Memory data )
 
 	dbLog( "checksum: %u", m_checksum );
 
-	m_prgMap.setMemorySize( m_prgSize );
-	m_chrMap.setMemorySize( m_chrSize );
+	m_prgMap.setMemory( m_prg, m_prgSize );
+	m_chrMap.setMemory( m_chr, m_chrSize );
+
+	if ( m_chrRam.size() > 0 )
+	{
+		m_chrRamTileCache = std::make_shared<TileCache>();
+		m_chrRamTileCache->decode( m_chr, m_chrSize );
+		m_tileCache = m_chrRamTileCache;
+	}
+	else
+	{
+		m_tileCache = m_data.share<TileCache>( [this]
+		{
+			TileCache tileCache;
+			tileCache.decode( m_chr, m_chrSize );
+			return tileCache;
+		} );
+	}
 
 	Cartridge::reset();
 }
@@ -57,6 +74,26 @@ void Cartridge::reset()
 
 	m_prgMap.reset();
 	m_chrMap.reset();
+	mapPrgSlots( 0, NumPrgSlots );
+}
+
+void Cartridge::setCPU( Cpu& cpu )
+{
+	m_cpu = &cpu;
+
+	if ( m_ram.size() >= PrgStart - RamStart )
+		m_cpu->mapReadPages( RamStart, m_ram.data(), PrgStart - RamStart );
+
+	mapPrgSlots( 0, NumPrgSlots );
+}
+
+void Cartridge::mapPrgSlots( size_t firstSlot, size_t numSlots )
+{
+	if ( !m_cpu )
+		return;
+
+	for ( size_t slot = firstSlot; slot < firstSlot + numSlots; ++slot )
+		m_cpu->mapReadPages( static_cast<Word>( PrgStart + slot * PrgBankSize ), m_prgMap.getSlot( slot ), PrgBankSize );
 }
 
 
@@ -65,7 +102,7 @@ Byte Cartridge::readPRG( Word address )
 	if ( address >= PrgStart )
 	{
 		// 0x8000 ... 0xffff
-		return m_prg[ m_prgMap[ address - PrgStart ] ];
+		return m_prgMap[ address - PrgStart ];
 	}
 	else if ( address >= RamStart )
 	{
@@ -80,11 +117,6 @@ Byte Cartridge::readPRG( Word address )
 	}
 }
 
-Byte Cartridge::readCHR( Word address )
-{
-	return m_chr[ m_chrMap[ address ] ];
-}
-
 void Cartridge::writePRG( Word address, Byte value )
 {
 	if ( address >= RamStart  && address < PrgStart )
@@ -97,8 +129,8 @@ void Cartridge::writeCHR( Word address, Byte value )
 {
 	if ( m_chrRam.size() > 0 )
 	{
-		dbAssert( address < getChrSize() );
-		m_chr[ address ] = value;
+		m_chrRam[ address ] = value;
+		m_chrRamTileCache->update( m_chrRam.data(), address );
 	}
 }
 
@@ -151,6 +183,10 @@ void Cartridge::saveState( ByteIO::Writer& writer )
 
 	writer.write( m_ram.data(), m_ram.size() );
 	writer.write( m_chrRam.data(), m_chrRam.size() );
+
+	writer.write( m_mirroring );
+	m_prgMap.saveState( writer );
+	m_chrMap.saveState( writer );
 }
 
 void Cartridge::loadState( ByteIO::Reader& reader )
@@ -159,4 +195,12 @@ void Cartridge::loadState( ByteIO::Reader& reader )
 
 	reader.read( m_ram.data(), m_ram.size() );
 	reader.read( m_chrRam.data(), m_chrRam.size() );
+
+	reader.read( m_mirroring );
+	m_prgMap.loadState( reader );
+	m_chrMap.loadState( reader );
+	mapPrgSlots( 0, NumPrgSlots );
+
+	if ( m_chrRam.size() > 0 )
+		m_chrRamTileCache->decode( m_chr, m_chrSize );
 }
\ No newline at end of file
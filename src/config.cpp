@@ -25,7 +25,13 @@ const char* DEFAULT_CONFIG = R"(
 			"scale": 2.0,
 			"sprite flickering": true,
 			"crop x": 8,
-			"crop y": 8
+			"crop y": 8,
+			"run ahead": 0,
+			"rewind buffer size": 16,
+			"audio buffer size": 8192,
+			"audio latency": 40,
+			"audio rate control": true,
+			"fast forward speed": 0
 		},
 		"paths": {
 			"rom folder": "roms",
@@ -126,6 +132,12 @@ void loadConfig()
 		render_scale = general["scale"].get<float>();
 		crop_area.x = general["crop x"].get<int>();
 		crop_area.y = general["crop y"].get<int>();
+		s_nes.setRunAhead( std::clamp( general["run ahead"].get<int>(), 0, nes::Nes::MaxRunAhead ) );
+		rewind_buffer.setCapacity( static_cast<size_t>( std::max( general["rewind buffer size"].get<int>(), 0 ) ) * 1024 * 1024 );
+		audio_ring.setCapacity( static_cast<size_t>( std::max( general["audio buffer size"].get<int>(), 1 ) ) );
+		audio_ring.setLatencyTarget( static_cast<size_t>( std::max( general["audio latency"].get<int>(), 0 ) ) * nes::Apu::SampleRate / 1000 );
+		audio_rate_control = general["audio rate control"].get<bool>();
+		fast_forward_speed = std::max( general["fast forward speed"].get<int>(), 0 );
 
 		crop_area.x = std::clamp( crop_area.x, 0, MaxCrop );
 		crop_area.y = std::clamp( crop_area.y, 0, MaxCrop );
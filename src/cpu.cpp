@@ -1,14 +1,18 @@
-#include "Cpu.hpp"
+#include "cpu.hpp"
 
 #include "apu.hpp"
-#include "Cartridge.hpp"
+#include "ByteIO.hpp"
+#include "cartridge.hpp"
 #include "common.hpp"
 #include "controller.hpp"
 #include "Instructions.hpp"
+#include "Opcodes.hpp"
 #include "ppu.hpp"
 
 #include "common.hpp"
 
+#include <algorithm>
+
 // #include "History.hpp"
 
 using namespace nes;
@@ -26,6 +30,7 @@ namespace
 	constexpr size_t PPU_START = 0x2000;
 	constexpr size_t PPU_SIZE = 0x0008;
 	constexpr size_t PPU_END = 0x3fff;
+	constexpr size_t PPU_STATUS = 0x2002;
 	/*
 	memory from 0x2008-0x3fff mirrors ppu registers
 	*/
@@ -48,6 +53,8 @@ namespace
 	constexpr size_t CARTRIDGE_START = 0x4020;
 	constexpr size_t CARTRIDGE_END = 0xffff;
 
+	constexpr size_t PRG_ROM_START = 0x8000;
+
 	constexpr size_t NMI_VECTOR = 0xfffa;
 	constexpr size_t RESET_VECTOR = 0xfffc;
 	constexpr size_t IRQ_VECTOR = 0xfffe;
@@ -72,17 +79,149 @@ namespace
 		return result & 0x100;
 	}
 
-	using CpuInstruction = void( Cpu::* )( void );
+#define COUNT_OPERATION( opcode, ... ) ++count;
 
-	struct Operation
+	constexpr size_t countListedOpcodes()
 	{
-		CpuInstruction func = nullptr;
-		Instruction instr = Instruction::illegalOpcode;
-		const char* instructionName = nullptr;
-		const char* addressModeName = nullptr;
+		size_t count = 0;
+		CPU_OPERATIONS( COUNT_OPERATION, COUNT_OPERATION, COUNT_OPERATION )
+		return count;
+	}
+
+#undef COUNT_OPERATION
+
+	constexpr size_t countSupportedOpcodes()
+	{
+		size_t count = 0;
+		for ( const Opcode& opcode : OpcodeTable )
+			count += ( opcode.instruction != Instruction::illegalOpcode ) ? 1 : 0;
+		return count;
+	}
+
+	// an opcode listed twice would silently replace the earlier entry
+	static_assert( countListedOpcodes() == countSupportedOpcodes() );
+
+	// how an instruction can appear in the body of an idle loop
+	enum class IdleAccess : Byte
+	{
+		None, // writes memory, uses the stack or changes the interrupt flag
+		Registers,
+		ZeroPage,
+		Absolute,
+		Branch,
+		Jump
 	};
 
-	Operation s_cpuOperations[ 0x100 ];
+	constexpr bool equal( const char* lhs, const char* rhs )
+	{
+		for ( ; *lhs && *lhs == *rhs; ++lhs, ++rhs ) {}
+		return *lhs == *rhs;
+	}
+
+	constexpr IdleAccess getIdleAccess( const Opcode& opcode )
+	{
+		switch ( opcode.instruction )
+		{
+			case Instruction::addWithCarry:
+			case Instruction::bitwiseAnd:
+			case Instruction::bitwiseOr:
+			case Instruction::compareWithAcc:
+			case Instruction::compareWithX:
+			case Instruction::compareWithY:
+			case Instruction::exclusiveOr:
+			case Instruction::loadAcc:
+			case Instruction::loadX:
+			case Instruction::loadY:
+			case Instruction::subtractFromAcc:
+			case Instruction::testBits:
+				if ( equal( opcode.addressMode, "Immediate" ) )
+					return IdleAccess::Registers;
+				if ( equal( opcode.addressMode, "ZeroPage" ) )
+					return IdleAccess::ZeroPage;
+				if ( equal( opcode.addressMode, "Absolute" ) )
+					return IdleAccess::Absolute;
+				return IdleAccess::None;
+
+			case Instruction::shiftLeft:
+			case Instruction::shiftRight:
+			case Instruction::rotateLeft:
+			case Instruction::rotateRight:
+				return equal( opcode.addressMode, "Accumulator" ) ? IdleAccess::Registers : IdleAccess::None;
+
+			case Instruction::clearCarryFlag:
+			case Instruction::clearDecimalFlag:
+			case Instruction::clearOverflowFlag:
+			case Instruction::setCarryFlag:
+			case Instruction::setDecimalFlag:
+			case Instruction::decrementX:
+			case Instruction::decrementY:
+			case Instruction::incrementX:
+			case Instruction::incrementY:
+			case Instruction::transferAccToX:
+			case Instruction::transferAccToY:
+			case Instruction::transferStackPointerToX:
+			case Instruction::transferXToAcc:
+			case Instruction::transferYToAcc:
+			case Instruction::noOperation:
+				return equal( opcode.addressMode, "Implied" ) ? IdleAccess::Registers : IdleAccess::None;
+
+			case Instruction::branchOnCarryClear:
+			case Instruction::branchOnCarrySet:
+			case Instruction::branchOnZero:
+			case Instruction::branchOnNegative:
+			case Instruction::branchOnNotZero:
+			case Instruction::branchOnPositive:
+			case Instruction::branchOnOverflowClear:
+			case Instruction::branchOnOverflowSet:
+				return IdleAccess::Branch;
+
+			case Instruction::jump:
+				return equal( opcode.addressMode, "Absolute" ) ? IdleAccess::Jump : IdleAccess::None;
+
+			default:
+				return IdleAccess::None;
+		}
+	}
+
+	constexpr auto IDLE_ACCESS = []
+	{
+		std::array<IdleAccess, 0x100> table{};
+		for ( size_t opcode = 0; opcode < table.size(); ++opcode )
+			table[ opcode ] = getIdleAccess( OpcodeTable[ opcode ] );
+		return table;
+	}();
+
+	static_assert( IDLE_ACCESS[ 0x4c ] == IdleAccess::Jump );
+	static_assert( IDLE_ACCESS[ 0x6c ] == IdleAccess::None );
+
+	// bytes from the loop head to the end of the closing jump
+	constexpr size_t MAX_IDLE_LOOP_SIZE = 32;
+
+	// instructions that may not continue with the next one in memory
+	constexpr bool endsBlock( Instruction instruction )
+	{
+		switch ( instruction )
+		{
+			case Instruction::branchOnCarryClear:
+			case Instruction::branchOnCarrySet:
+			case Instruction::branchOnZero:
+			case Instruction::branchOnNegative:
+			case Instruction::branchOnNotZero:
+			case Instruction::branchOnPositive:
+			case Instruction::branchOnOverflowClear:
+			case Instruction::branchOnOverflowSet:
+			case Instruction::forceBreak:
+			case Instruction::jump:
+			case Instruction::jumpToSubroutine:
+			case Instruction::returnFromInterrupt:
+			case Instruction::returnFromSubroutine:
+			case Instruction::illegalOpcode:
+				return true;
+
+			default:
+				return false;
+		}
+	}
 }
 
 enum class Cpu::AddressMode
@@ -184,9 +323,50 @@ enum class Cpu::AddressMode
 	*/
 };
 
+Cpu::Cpu()
+	: m_blocks( NumBlocks )
+{
+	// internal RAM is mirrored up to the PPU registers
+	for ( Word address = RAM_START; address < RAM_END; address += RamSize )
+		mapReadPages( address, m_ram.data(), RamSize );
+}
+
+void Cpu::setCartridge( Cartridge* cartridge )
+{
+	m_cartridge = cartridge;
+	m_idleLoop = IdleLoop{};
+
+	// blocks are keyed by pointers into the old cartridge's memory
+	for ( Block& block : m_blocks )
+		block = Block{};
+
+	// the cartridge maps its own pages
+	unmapReadPages( CARTRIDGE_START, CARTRIDGE_END + 1 - CARTRIDGE_START );
+}
+
+void Cpu::mapReadPages( Word address, const Byte* data, size_t size )
+{
+	dbAssert( address % PageSize == 0 );
+	dbAssert( size % PageSize == 0 );
+	dbAssert( address + size <= 0x10000 );
+
+	const size_t firstPage = address / PageSize;
+	for ( size_t i = 0; i < size / PageSize; ++i )
+		m_readPages[ firstPage + i ] = data + i * PageSize;
+}
+
+void Cpu::unmapReadPages( Word address, size_t size )
+{
+	const size_t firstPage = address / PageSize;
+	const size_t lastPage = ( address + size + PageSize - 1 ) / PageSize;
+	for ( size_t page = firstPage; page < lastPage; ++page )
+		m_readPages[ page ] = nullptr;
+}
+
 void Cpu::power()
 {
 	m_cycles = 0;
+	m_ppu->setClock( m_masterClock );
 
 	m_stackPointer = STACK_START;
 	m_status = STATUS_START;
@@ -195,6 +375,10 @@ void Cpu::power()
 	m_xRegister = 0;
 	m_yRegister = 0;
 
+	// power on contents are undefined, clearing keeps power cycles reproducible
+	m_ram.fill( 0 );
+	invalidateAllRamCode();
+
 	write( APU_STATUS, 0 );
 	write( APU_FRAME_COUNT, 0 );
 	for ( Word i = 0; i < 16; ++i )
@@ -204,14 +388,16 @@ void Cpu::power()
 	dbLog( "PC: 0x%04", m_programCounter );
 
 	m_halt = false;
-	m_nmi = -1;
-	m_irq = -1;
+	m_nmiTime = -1;
+	m_irqTime = -1;
 	m_oddCycle = false;
+	m_idleLoop = IdleLoop{};
 }
 
 void Cpu::reset()
 {
 	m_cycles = 0;
+	m_ppu->setClock( m_masterClock );
 
 	m_stackPointer -= 3;
 	setStatus( DisableInterrupts );
@@ -221,59 +407,204 @@ void Cpu::reset()
 	dbLog( "PC: 0x%04", m_programCounter );
 
 	m_halt = false;
-	m_nmi = -1;
-	m_irq = -1;
+	m_nmiTime = -1;
+	m_irqTime = -1;
 	m_oddCycle = false;
+	m_idleLoop = IdleLoop{};
 }
 
 void Cpu::executeInstruction()
 {
 	if ( ! halted() )
 	{
-		if ( testStatus( DisableInterrupts ) )
-			m_irq = -1;
+		syncPpuEvents();
+		step();
+	}
+}
 
-		if ( m_nmi >= 2 )
-		{
-			m_nmi = -1;
-			nmi();
-			return;
-		}
+void Cpu::step()
+{
+	// nothing to poll in the common case of no raised interrupt
+	if ( ( m_nmiTime >= 0 || m_irqTime >= 0 ) && serviceInterrupt() )
+		return;
 
-		if ( m_irq >= 2 )
-		{
-			m_irq = -1;
-			irq();
-			return;
-		}
+	Byte opcode = readByteTick( m_programCounter++ );
+	executeOpcode( opcode );
+}
 
-		Byte opcode = readByteTick( m_programCounter++ );
-		auto operation = s_cpuOperations[ opcode ];
-		( this->*operation.func )();
+bool Cpu::serviceInterrupt()
+{
+	if ( testStatus( DisableInterrupts ) )
+		m_irqTime = -1;
+
+	if ( interruptPending( m_nmiTime ) )
+	{
+		m_nmiTime = -1;
+		nmi();
+		return true;
+	}
+
+	if ( interruptPending( m_irqTime ) )
+	{
+		m_irqTime = -1;
+		irq();
+		return true;
 	}
+
+	return false;
 }
 
 void Cpu::runFrame()
 {
 	m_cycles = 0;
-	while ( !halted() && !m_ppu->readyToDraw() )
+	while ( !halted() )
 	{
-		executeInstruction();
+		syncPpuEvents();
+		if ( m_ppu->readyToDraw() )
+			break;
+
+		// instructions are stepped one at a time while an interrupt is raised
+		const Block* block = ( m_nmiTime < 0 && m_irqTime < 0 ) ? findBlock() : nullptr;
+		if ( !block )
+			step();
+		else if ( !runBlock( *block ) )
+			break;
 	}
 
 	m_apu->runFrame( m_cycles );
 }
 
-void Cpu::tick()
+const Cpu::Block* Cpu::findBlock()
+{
+	const Word address = m_programCounter;
+
+	// code in cartridge ram or registers is always stepped
+	const Byte* page = m_readPages[ address / PageSize ];
+	if ( !page || ( address >= RamMirrorEnd && address < PRG_ROM_START ) )
+		return nullptr;
+
+	const Byte* code = page + address % PageSize;
+	Block& block = m_blocks[ address % NumBlocks ];
+	if ( block.address != address || block.code != code
+		|| ( block.inRam && block.ramVersion != m_ramVersions[ address % RamSize / PageSize ] ) )
+	{
+		decodeBlock( block, address, code );
+	}
+
+	return block.count > 0 ? &block : nullptr;
+}
+
+void Cpu::decodeBlock( Block& block, Word address, const Byte* code )
+{
+	block.address = address;
+	block.code = code;
+	block.inRam = address < RamMirrorEnd;
+	block.count = 0;
+
+	if ( block.inRam )
+	{
+		const size_t ramPage = address % RamSize / PageSize;
+		block.ramVersion = m_ramVersions[ ramPage ];
+		m_ramCodePages |= 1u << ramPage;
+	}
+
+	// blocks stay in one page, the next one may be mapped elsewhere
+	const size_t end = PageSize - address % PageSize;
+	for ( size_t offset = 0; block.count < MaxBlockInstructions; )
+	{
+		const Byte opcode = code[ offset ];
+		const Opcode& info = OpcodeTable[ opcode ];
+		if ( offset + info.length > end )
+			break;
+
+		DecodedInstruction& instruction = block.instructions[ block.count++ ];
+		instruction.operation = s_decodedOperations[ opcode ];
+		instruction.address = static_cast<Word>( address + offset );
+		instruction.length = info.length;
+		instruction.operand = ( info.length > 1 ) ? code[ offset + 1 ] : 0;
+		if ( info.length > 2 )
+			instruction.operand |= code[ offset + 2 ] << 8;
+
+		offset += info.length;
+
+		if ( !instruction.operation || endsBlock( info.instruction ) )
+			break;
+	}
+}
+
+bool Cpu::runBlock( const Block& block )
 {
-	m_oddCycle = !m_oddCycle;
-	for ( int i = 0; i < 3; ++i )
+	for ( size_t i = 0;; )
 	{
-		m_nmi += ( m_nmi >= 0 );
-		m_irq += ( m_irq >= 0 );
-		m_ppu->tick();
+		executeDecoded( block.instructions[ i ] );
+		if ( ++i == block.count )
+			return true;
+
+		// the rest of the block may have been rewritten
+		if ( block.inRam && block.ramVersion != m_ramVersions[ block.address % RamSize / PageSize ] )
+			return true;
+
+		// the same checks runFrame makes between instructions
+		syncPpuEvents();
+		if ( m_ppu->readyToDraw() )
+			return false;
+
+		if ( m_nmiTime >= 0 || m_irqTime >= 0 )
+			return true;
 	}
-	++m_cycles;
+}
+
+void Cpu::executeDecoded( const DecodedInstruction& instruction )
+{
+	if ( !instruction.operation )
+	{
+		m_programCounter = instruction.address;
+		Byte opcode = readByteTick( m_programCounter++ );
+		executeOpcode( opcode );
+		return;
+	}
+
+	// the opcode and operand reads are from memory without side effects, only their cycles are left
+	tick();
+	m_programCounter = instruction.address + instruction.length;
+	m_decodedOperand = instruction.operand;
+	( this->*instruction.operation )();
+}
+
+void Cpu::invalidateRamCode( Word address )
+{
+	const size_t ramPage = address % RamSize / PageSize;
+	m_ramCodePages &= ~( 1u << ramPage );
+	++m_ramVersions[ ramPage ];
+}
+
+void Cpu::invalidateAllRamCode()
+{
+	for ( uint32_t& version : m_ramVersions )
+		++version;
+
+	m_ramCodePages = 0;
+}
+
+void Cpu::setNMI( bool on )
+{
+	m_nmiTime = on ? m_ppu->getClock() : -1;
+}
+
+void Cpu::setIRQ( bool on )
+{
+	m_irqTime = on ? m_ppu->getClock() : -1;
+}
+
+void Cpu::syncPpu()
+{
+	m_ppu->runTo( m_masterClock );
+}
+
+void Cpu::syncPpuEvents()
+{
+	if ( m_masterClock >= m_ppu->getNextEventClock() )
+		m_ppu->runTo( m_masterClock );
 }
 
 void Cpu::setArithmeticFlags( Byte value )
@@ -304,17 +635,18 @@ void Cpu::oamDmaTransfer( Byte addressHigh )
 	{
 		Byte data = readByteTick( address );
 		tick();
+		syncPpu();
 		m_ppu->writeToOAM( data );
 	}
 }
 
-Byte Cpu::read( Word address )
+Byte Cpu::readIO( Word address )
 {
-	if ( RAM_START <= address && address <= RAM_END )
-		return m_ram[ address - RAM_START ];
-
 	if ( PPU_START <= address && address <= PPU_END )
+	{
+		syncPpu();
 		return m_ppu->readRegister( ( address - PPU_START ) % PPU_SIZE );
+	}
 
 	if ( APU_START <= address && address <= APU_END )
 	{
@@ -326,6 +658,8 @@ Byte Cpu::read( Word address )
 
 	if ( JOY1 <= address && address <= JOY2 )
 	{
+		// the zapper senses the pixels drawn so far
+		syncPpu();
 		auto* controller = m_controllerPorts[ address - JOY1 ];
 		return controller ? controller->read() : 0;
 	}
@@ -336,14 +670,11 @@ Byte Cpu::read( Word address )
 	return 0;
 }
 
-void Cpu::write( Word address, Byte value )
+void Cpu::writeIO( Word address, Byte value )
 {
-	if ( RAM_START <= address && address <= RAM_END )
-	{
-		m_ram[ address - RAM_START ] = value;
-	}
-	else if ( PPU_START <= address && address <= PPU_END )
+	if ( PPU_START <= address && address <= PPU_END )
 	{
+		syncPpu();
 		m_ppu->writeRegister( ( address - PPU_START ) % PPU_SIZE, value );
 	}
 	else if ( ( APU_START <= address && address <= APU_END ) || address == JOY2 )
@@ -356,16 +687,22 @@ void Cpu::write( Word address, Byte value )
 	else if ( address == JOY1 )
 	{
 		for ( auto* controller : m_controllerPorts )
-			controller->write( value );
+		{
+			if ( controller )
+				controller->write( value );
+		}
 	}
 	else if ( CARTRIDGE_START <= address && address <= CARTRIDGE_END )
 	{
+		// mapper writes can switch CHR banks, mirroring and scanline IRQs
+		syncPpu();
 		m_cartridge->writePRG( address, value );
 	}
 }
 
 void Cpu::nmi()
 {
+	m_idleLoop.clock = -1;
 	tick();
 	tick();
 	pushWord( m_programCounter );
@@ -376,6 +713,7 @@ void Cpu::nmi()
 
 void Cpu::irq()
 {
+	m_idleLoop.clock = -1;
 	tick();
 	tick();
 	setStatus( Break );
@@ -398,55 +736,198 @@ void Cpu::conditionalBranch( bool branch )
 		{
 			tick();
 		}
+
+		if ( offset < 0 )
+			checkIdleLoop( page1 - OpcodeLength::Relative );
+	}
+	else if ( static_cast<Word>( m_programCounter - OpcodeLength::Relative ) == m_idleLoop.end )
+	{
+		// fell out of the loop
+		m_idleLoop.clock = -1;
+	}
+}
+
+void Cpu::setIdleLoopSkipping( bool skip )
+{
+	m_idleLoopSkipping = skip;
+	m_idleLoop = IdleLoop{};
+}
+
+void Cpu::checkIdleLoop( Word end )
+{
+	if ( !m_idleLoopSkipping )
+		return;
+
+	IdleLoop& loop = m_idleLoop;
+	const Word head = m_programCounter;
+	const Byte* page = m_readPages[ head / PageSize ];
+	if ( head != loop.head || end != loop.end || page != loop.page )
+	{
+		loop = IdleLoop{};
+		loop.head = head;
+		loop.end = end;
+		loop.page = page;
+		loop.idle = analyzeIdleLoop( loop );
 	}
+
+	if ( !loop.idle )
+		return;
+
+	const bool repeated = loop.clock >= 0
+		&& loop.accumulator == m_accumulator
+		&& loop.xRegister == m_xRegister
+		&& loop.yRegister == m_yRegister
+		&& loop.stackPointer == m_stackPointer
+		&& loop.status == m_status;
+
+	const int64_t iterationDots = m_masterClock - loop.clock;
+
+	loop.clock = m_masterClock;
+	loop.accumulator = m_accumulator;
+	loop.xRegister = m_xRegister;
+	loop.yRegister = m_yRegister;
+	loop.stackPointer = m_stackPointer;
+	loop.status = m_status;
+
+	// an iteration that changed nothing repeats exactly until an interrupt or the PPU changes what it reads
+	if ( !repeated || m_nmiTime >= 0 || m_irqTime >= 0 )
+		return;
+
+	// a due event is handled before the next instruction
+	int64_t until = m_ppu->getNextEventClock();
+	if ( until <= m_masterClock )
+		return;
+
+	if ( loop.readsStatus )
+	{
+		syncPpu();
+		until = std::min( until, m_ppu->getStatusStableClock() );
+	}
+
+	// stop at the head of the iteration the event lands in so it runs normally
+	const int64_t iterations = ( until - m_masterClock ) / iterationDots;
+	if ( iterations <= 0 )
+		return;
+
+	const int64_t cycles = iterations * ( iterationDots / PpuDotsPerCycle );
+	m_masterClock += iterations * iterationDots;
+	m_cycles += static_cast<int>( cycles );
+	if ( cycles % 2 )
+		m_oddCycle = !m_oddCycle;
+
+	loop.clock = m_masterClock;
 }
 
-template <Cpu::AddressMode Mode>
+bool Cpu::analyzeIdleLoop( IdleLoop& loop ) const
+{
+	// code in ram could be rewritten by the loop
+	if ( !loop.page || loop.head < PRG_ROM_START || loop.end < loop.head )
+		return false;
+
+	// the body and the closing jump's operand must be in the same page
+	const size_t size = loop.end - loop.head + OpcodeLength::Absolute;
+	if ( size > MAX_IDLE_LOOP_SIZE || loop.head % PageSize + size > PageSize )
+		return false;
+
+	const Byte* body = loop.page + loop.head % PageSize;
+	uint32_t instructions = 0;
+	uint32_t targets = 0;
+
+	for ( size_t offset = 0;; offset += OpcodeTable[ body[ offset ] ].length )
+	{
+		const Word address = static_cast<Word>( loop.head + offset );
+		if ( address > loop.end )
+			return false;
+
+		instructions |= 1u << offset;
+
+		int target = address;
+		switch ( IDLE_ACCESS[ body[ offset ] ] )
+		{
+			case IdleAccess::None:
+				return false;
+
+			case IdleAccess::Registers:
+			case IdleAccess::ZeroPage:
+				break;
+
+			case IdleAccess::Absolute:
+			{
+				const Word operand = static_cast<Word>( body[ offset + 1 ] | ( body[ offset + 2 ] << 8 ) );
+				if ( PPU_START <= operand && operand <= PPU_END && ( operand - PPU_START ) % PPU_SIZE == PPU_STATUS - PPU_START )
+					loop.readsStatus = true;
+				else if ( !m_readPages[ operand / PageSize ] )
+					return false;
+				break;
+			}
+
+			case IdleAccess::Branch:
+				target = address + OpcodeLength::Relative + static_cast<int8_t>( body[ offset + 1 ] );
+				break;
+
+			case IdleAccess::Jump:
+				target = body[ offset + 1 ] | ( body[ offset + 2 ] << 8 );
+				break;
+		}
+
+		// anything that leaves the body could reach code with side effects
+		if ( target < loop.head || target > loop.end )
+			return false;
+
+		targets |= 1u << ( target - loop.head );
+
+		if ( address == loop.end )
+			break;
+	}
+
+	// jumps inside the body must land on the instructions that were checked
+	return ( targets & ~instructions ) == 0;
+}
+
+template <Cpu::AddressMode Mode, bool Decoded>
 Word Cpu::getAddress()
 {
 	switch ( Mode )
 	{
 		case AddressMode::Immediate:
-			return m_programCounter++;
+			// a decoded instruction already moved the program counter past its operand
+			if constexpr ( Decoded )
+				return m_programCounter - 1;
+			else
+				return m_programCounter++;
 
 		case AddressMode::Absolute:
-		{
-			Word address = readWordTick( m_programCounter );
-			m_programCounter += 2;
-			return address;
-		}
+			return fetchOperandWord<Decoded>();
 
 		case AddressMode::ZeroPage:
-			return readByteTick( m_programCounter++ );
+			return fetchOperandByte<Decoded>();
 
 		case AddressMode::ZeroPageX:
 		{
-			Word address = ( readByteTick( m_programCounter++ ) + m_xRegister ) & 0xff;
+			Word address = ( fetchOperandByte<Decoded>() + m_xRegister ) & 0xff;
 			tick();
 			return address;
 		}
 
 		case AddressMode::ZeroPageY:
 		{
-			Word address = ( readByteTick( m_programCounter++ ) + m_yRegister ) & 0xff;
+			Word address = ( fetchOperandByte<Decoded>() + m_yRegister ) & 0xff;
 			tick();
 			return address;
 		}
 
 		case AddressMode::AbsoluteX:
 		{
-			Word page1 = readWordTick( m_programCounter );
+			Word page1 = fetchOperandWord<Decoded>();
 			auto address = page1 + m_xRegister;
 			if ( crossedPage( page1, address ) )
 				dummyRead( address - 0x100 );
-			m_programCounter += 2;
 			return address;
 		}
 
 		case AddressMode::AbsoluteXStore:
 		{
-			Word page1 = readWordTick( m_programCounter );
-			m_programCounter += 2;
+			Word page1 = fetchOperandWord<Decoded>();
 			Word address = page1 + m_xRegister;
 			dummyRead( address - ( crossedPage( page1, address ) ? 0x100 : 0 ) );
 			return address;
@@ -454,40 +935,34 @@ Word Cpu::getAddress()
 
 		case AddressMode::AbsoluteY:
 		{
-			Word page1 = readWordTick( m_programCounter );
+			Word page1 = fetchOperandWord<Decoded>();
 			Word address = page1 + m_yRegister;
 			if ( crossedPage( page1, address ) )
 				dummyRead( address - 0x100 );
-			m_programCounter += 2;
 			return address;
 		}
 
 		case AddressMode::AbsoluteYStore:
 		{
-			Word page1 = readWordTick( m_programCounter );
-			m_programCounter += 2;
+			Word page1 = fetchOperandWord<Decoded>();
 			Word address = page1 + m_yRegister;
 			dummyRead( address - ( crossedPage( page1, address ) ? 0x100 : 0 ) );
 			return address;
 		}
 
 		case AddressMode::Indirect:
-		{
-			Word address = readWordTickBug( readWordTick( m_programCounter ) );
-			m_programCounter += 2;
-			return address;
-		}
+			return readWordTickBug( fetchOperandWord<Decoded>() );
 
 		case AddressMode::IndirectX:
 		{
-			Word zp = ( readByteTick( m_programCounter++ ) + m_xRegister ) & 0xff;
+			Word zp = ( fetchOperandByte<Decoded>() + m_xRegister ) & 0xff;
 			tick();
 			return readWordTickBug( zp );
 		}
 
 		case AddressMode::IndirectY:
 		{
-			Word zp = readByteTick( m_programCounter++ );
+			Word zp = fetchOperandByte<Decoded>();
 			Word address = readWordTickBug( zp ) + m_yRegister;
 			if ( crossedPage( address - m_yRegister, address ) )
 				dummyRead( address - 0x100 );
@@ -496,7 +971,7 @@ Word Cpu::getAddress()
 
 		case AddressMode::IndirectYStore:
 		{
-			Word page1 = readWordTickBug( readByteTick( m_programCounter++ ) );
+			Word page1 = readWordTickBug( fetchOperandByte<Decoded>() );
 			Word address = page1 + m_yRegister;
 			dummyRead( address - ( crossedPage( page1, address ) ? 0x100 : 0 ) );
 			return address;
@@ -524,23 +999,23 @@ void Cpu::buggyIndexWrite( Byte index, Byte value )
 ////////////////////////////////////////////////////////////////////////////////
 
 // ADC
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::addWithCarry()
 {
-	addToAccumulator( readByteTick( getAddress<Mode>() ) );
+	addToAccumulator( readByteTick( getAddress<Mode, Decoded>() ) );
 }
 
 // AND
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::bitwiseAnd()
 {
-	Byte value = readByteTick( getAddress<Mode>() );
+	Byte value = readByteTick( getAddress<Mode, Decoded>() );
 	m_accumulator &= value;
 	setArithmeticFlags( m_accumulator );
 }
 
 // ASL
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::shiftLeft()
 {
 	int result;
@@ -552,7 +1027,7 @@ void Cpu::shiftLeft()
 	}
 	else
 	{
-		Word address = getAddress<Mode>();
+		Word address = getAddress<Mode, Decoded>();
 		result = readByteTick( address ) << 1;
 		tick();
 		writeByteTick( address, result );
@@ -580,10 +1055,10 @@ void Cpu::branchOnZero()
 }
 
 // BIT
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::testBits()
 {
-	Byte value = readByteTick( getAddress<Mode>() );
+	Byte value = readByteTick( getAddress<Mode, Decoded>() );
 	setStatus( Negative, value & Negative );
 	setStatus( Overflow, value & Overflow );
 	setStatus( Zero, ( value & m_accumulator ) == 0 );
@@ -659,31 +1134,31 @@ void Cpu::clearOverflowFlag()
 }
 
 // CMP
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::compareWithAcc()
 {
-	compareWithValue<Mode>( m_accumulator );
+	compareWithValue<Mode, Decoded>( m_accumulator );
 }
 
 // CPX
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::compareWithX()
 {
-	compareWithValue<Mode>( m_xRegister );
+	compareWithValue<Mode, Decoded>( m_xRegister );
 }
 
 // CPY
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::compareWithY()
 {
-	compareWithValue<Mode>( m_yRegister );
+	compareWithValue<Mode, Decoded>( m_yRegister );
 }
 
 // DEC
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::decrement()
 {
-	Word address = getAddress<Mode>();
+	Word address = getAddress<Mode, Decoded>();
 	Byte result = readByteTick( address ) - 1;
 	tick();
 	setArithmeticFlags( result );
@@ -705,18 +1180,18 @@ void Cpu::decrementY()
 }
 
 // EOR
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::exclusiveOr()
 {
-	m_accumulator ^= readByteTick( getAddress<Mode>() );
+	m_accumulator ^= readByteTick( getAddress<Mode, Decoded>() );
 	setArithmeticFlags( m_accumulator );
 }
 
 // INC
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::increment()
 {
-	Word address = getAddress<Mode>();
+	Word address = getAddress<Mode, Decoded>();
 	Byte result = readByteTick( address ) + 1;
 	tick();
 	setArithmeticFlags( result );
@@ -738,47 +1213,58 @@ void Cpu::incrementY()
 }
 
 // JMP
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::jump()
 {
-	m_programCounter = getAddress<Mode>();
+	// the jump's own address, a decoded jump is already past its operand
+	const Word address = m_programCounter - ( Decoded ? OpcodeLength::Absolute : 1 );
+	m_programCounter = getAddress<Mode, Decoded>();
+
+	if constexpr ( Mode == AddressMode::Absolute )
+	{
+		if ( m_programCounter <= address )
+			checkIdleLoop( address );
+	}
 }
 
 // JSR
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::jumpToSubroutine()
 {
 	tick();
-	pushWord( m_programCounter + 1 );
-	m_programCounter = readWordTick( m_programCounter );
+
+	// the pushed return address is the last byte of the instruction
+	const Word returnAddress = Decoded ? m_programCounter - 1 : m_programCounter + 1;
+	pushWord( returnAddress );
+	m_programCounter = fetchOperandWord<Decoded>();
 }
 
 // LDA
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::loadAcc()
 {
-	m_accumulator = readByteTick( getAddress<Mode>() );
+	m_accumulator = readByteTick( getAddress<Mode, Decoded>() );
 	setArithmeticFlags( m_accumulator );
 }
 
 // LDX
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::loadX()
 {
-	m_xRegister = readByteTick( getAddress<Mode>() );
+	m_xRegister = readByteTick( getAddress<Mode, Decoded>() );
 	setArithmeticFlags( m_xRegister );
 }
 
 // LDY
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::loadY()
 {
-	m_yRegister = readByteTick( getAddress<Mode>() );
+	m_yRegister = readByteTick( getAddress<Mode, Decoded>() );
 	setArithmeticFlags( m_yRegister );
 }
 
 // LSR
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::shiftRight()
 {
 	Byte result;
@@ -793,7 +1279,7 @@ void Cpu::shiftRight()
 	}
 	else
 	{
-		Word address = getAddress<Mode>();
+		Word address = getAddress<Mode, Decoded>();
 		Byte value = readByteTick( address );
 		carry = value & 1;
 		result = value >> 1;
@@ -812,10 +1298,10 @@ void Cpu::noOperation()
 }
 
 // ORA
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::bitwiseOr()
 {
-	m_accumulator |= readByteTick( getAddress<Mode>() );
+	m_accumulator |= readByteTick( getAddress<Mode, Decoded>() );
 	setArithmeticFlags( m_accumulator );
 }
 
@@ -851,7 +1337,7 @@ void Cpu::popStatus()
 }
 
 // ROL
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::rotateLeft()
 {
 	bool carry;
@@ -866,7 +1352,7 @@ void Cpu::rotateLeft()
 	}
 	else
 	{
-		Word address = getAddress<Mode>();
+		Word address = getAddress<Mode, Decoded>();
 		result = readByteTick( address );
 		carry = testAnyFlag<Byte>( result, 0x80 );
 		result = ( result << 1 ) | (Byte)testStatus( Carry );
@@ -879,7 +1365,7 @@ void Cpu::rotateLeft()
 }
 
 // ROR
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::rotateRight()
 {
 	bool carry;
@@ -894,7 +1380,7 @@ void Cpu::rotateRight()
 	}
 	else
 	{
-		Word address = getAddress<Mode>();
+		Word address = getAddress<Mode, Decoded>();
 		result = readByteTick( address );
 		carry = result & 1;
 		result = ( result >> 1 ) | ( testStatus( Carry ) ? 0x80 : 0 );
@@ -924,10 +1410,10 @@ void Cpu::returnFromSubroutine()
 }
 
 // SBS
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::subtractFromAcc()
 {
-	addToAccumulator( ~readByteTick( getAddress<Mode>() ) );
+	addToAccumulator( ~readByteTick( getAddress<Mode, Decoded>() ) );
 }
 
 // SEC
@@ -952,24 +1438,24 @@ void Cpu::setInterruptDisableFlag()
 }
 
 // STA
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::storeAcc()
 {
-	writeByteTick( getAddress<Mode>(), m_accumulator );
+	writeByteTick( getAddress<Mode, Decoded>(), m_accumulator );
 }
 
 // STX
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::storeX()
 {
-	writeByteTick( getAddress<Mode>(), m_xRegister );
+	writeByteTick( getAddress<Mode, Decoded>(), m_xRegister );
 }
 
 // STY
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::storeY()
 {
-	writeByteTick( getAddress<Mode>(), m_yRegister );
+	writeByteTick( getAddress<Mode, Decoded>(), m_yRegister );
 }
 
 // TAX
@@ -1028,29 +1514,29 @@ void Cpu::illegalOpcode()
 // unofficial opcodes
 
 // ALR
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::andShiftRight()
 {
-	m_accumulator &= readByteTick( getAddress<Mode>() );
+	m_accumulator &= readByteTick( getAddress<Mode, Decoded>() );
 	setStatus( Carry, m_accumulator & 1 );
 	m_accumulator >>= 1;
 	setArithmeticFlags( m_accumulator );
 }
 
 // ANC
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::andSetCarry()
 {
-	m_accumulator &= readByteTick( getAddress<Mode>() );
+	m_accumulator &= readByteTick( getAddress<Mode, Decoded>() );
 	setArithmeticFlags( m_accumulator );
 	setStatus( Carry, m_accumulator & 0x80 );
 }
 
 // ARR
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::andRotateRight()
 {
-	m_accumulator &= readByteTick( getAddress<Mode>() );
+	m_accumulator &= readByteTick( getAddress<Mode, Decoded>() );
 	m_accumulator = ( m_accumulator >> 1 ) | ( testStatus( Carry ) ? 0x80 : 0 );
 	setArithmeticFlags( m_accumulator );
 	setStatus( Carry, 0x40 & m_accumulator );
@@ -1058,10 +1544,10 @@ void Cpu::andRotateRight()
 }
 
 // AXS
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::subtractFromAccAndX()
 {
-	Byte value = readByteTick( getAddress<Mode>() );
+	Byte value = readByteTick( getAddress<Mode, Decoded>() );
 	int result = ( m_accumulator & m_xRegister ) - value;
 	setStatus( Carry, ( m_accumulator & m_xRegister ) >= value );
 	m_xRegister = result & 0xff;
@@ -1069,25 +1555,25 @@ void Cpu::subtractFromAccAndX()
 }
 
 // LAX
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::loadAccTransferToX()
 {
-	m_xRegister = m_accumulator = readByteTick( getAddress<Mode>() );
+	m_xRegister = m_accumulator = readByteTick( getAddress<Mode, Decoded>() );
 	setArithmeticFlags( m_accumulator );
 }
 
 // SAX, AXA
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::storeAccAndX()
 {
-	writeByteTick( getAddress<Mode>(), m_accumulator & m_xRegister );
+	writeByteTick( getAddress<Mode, Decoded>(), m_accumulator & m_xRegister );
 }
 
 // DCP
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::decrementCompare()
 {
-	Word address = getAddress<Mode>();
+	Word address = getAddress<Mode, Decoded>();
 	Byte value = readByteTick( address ) - 1;
 	writeByteTick( address, value );
 
@@ -1097,10 +1583,10 @@ void Cpu::decrementCompare()
 }
 
 // ISC
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::incrementSubtract()
 {
-	Word address = getAddress<Mode>();
+	Word address = getAddress<Mode, Decoded>();
 	Byte value = readByteTick( address ) + 1;
 	tick();
 	writeByteTick( address, value );
@@ -1109,10 +1595,10 @@ void Cpu::incrementSubtract()
 }
 
 // RLA
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::rotateLeftAnd()
 {
-	Word address = getAddress<Mode>();
+	Word address = getAddress<Mode, Decoded>();
 	Byte value = readByteTick( address );
 	tick();
 	bool carry = value & 0x80;
@@ -1124,10 +1610,10 @@ void Cpu::rotateLeftAnd()
 }
 
 // RRA
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::rotateRightAdd()
 {
-	Word address = getAddress<Mode>();
+	Word address = getAddress<Mode, Decoded>();
 	Byte value = readByteTick( address );
 	tick();
 	bool carry = value & 1;
@@ -1139,10 +1625,10 @@ void Cpu::rotateRightAdd()
 }
 
 // SLO
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::shiftLeftOrAcc()
 {
-	Word address = getAddress<Mode>();
+	Word address = getAddress<Mode, Decoded>();
 	Byte value = readByteTick( address );
 	tick();
 	setStatus( Carry, value & 0x80 );
@@ -1154,10 +1640,10 @@ void Cpu::shiftLeftOrAcc()
 }
 
 // SRE
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::shiftRightExclusiveOr()
 {
-	Word address = getAddress<Mode>();
+	Word address = getAddress<Mode, Decoded>();
 	Byte value = readByteTick( address );
 	tick();
 	setStatus( Carry, value & 1 );
@@ -1169,19 +1655,19 @@ void Cpu::shiftRightExclusiveOr()
 }
 
 // XAA
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::transferXToAccAnd()
 {
 	m_accumulator = m_xRegister;
-	m_accumulator &= readByteTick( getAddress<Mode>() );
+	m_accumulator &= readByteTick( getAddress<Mode, Decoded>() );
 }
 
 // OAL
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::orAndAccSetAccX()
 {
 	m_accumulator |= 0xee;
-	m_accumulator &= readByteTick( getAddress<Mode>() );
+	m_accumulator &= readByteTick( getAddress<Mode, Decoded>() );
 	m_xRegister = m_accumulator;
 }
 
@@ -1198,406 +1684,149 @@ void Cpu::andYAddrHigh()
 }
 
 // XAS
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::andXAccStoreStackPointer()
 {
-	Word address = getAddress<Mode>();
+	Word address = getAddress<Mode, Decoded>();
 	m_stackPointer = m_xRegister & m_accumulator;
 	writeByteTick( address, m_stackPointer & ( ( address >> 8 ) + 1 ) );
 }
 
 //SHA
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::andXAccSeven()
 {
-	Word address = getAddress<Mode>();
+	Word address = getAddress<Mode, Decoded>();
 	writeByteTick( address, m_xRegister & m_accumulator & 0x07 );
 }
 
 // LAR
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::andSPTransferToAcXSP()
 {
-	m_accumulator = m_xRegister = m_stackPointer = readByteTick( getAddress<Mode>() ) & m_stackPointer;
+	m_accumulator = m_xRegister = m_stackPointer = readByteTick( getAddress<Mode, Decoded>() ) & m_stackPointer;
 	setArithmeticFlags( m_accumulator );
 }
 
 // IGN
-template <Cpu::AddressMode Mode>
+template <Cpu::AddressMode Mode, bool Decoded>
 void Cpu::ignoreByte()
 {
-	Word address = getAddress<Mode>();
+	Word address = getAddress<Mode, Decoded>();
 	readByteTick( address );
 }
 
 
-#define CHECK_NULL_OR_ILL( opcode )	do {		\
-	auto func = s_cpuOperations[ opcode ].func;	\
-	dbAssert( func == nullptr || func == &Cpu::illegalOpcode ); } while( false )
-
-#define SET_ADDRMODE_OP( opcode, instr, addrmode ) 	\
-	CHECK_NULL_OR_ILL( opcode );					\
-	s_cpuOperations[ opcode ] = { &Cpu::instr< Cpu::AddressMode::addrmode >, Instruction::instr, #instr, #addrmode };
-
-#define SET_IMPLIED( opcode, instr )	\
-	CHECK_NULL_OR_ILL( opcode );		\
-	s_cpuOperations[ opcode ] = { &Cpu::instr, Instruction::instr, #instr, "Implied" };
+#ifdef NES_CPU_SWITCH_DISPATCH
 
-#define SET_BRANCH( opcode, instr )	\
-	CHECK_NULL_OR_ILL( opcode );	\
-	s_cpuOperations[ opcode ] = { &Cpu::instr, Instruction::instr, #instr, "Relative" };
+#define CASE_ADDRMODE_OP( opcode, instr, addrmode ) case opcode: instr<AddressMode::addrmode>(); break;
+#define CASE_IMPLIED( opcode, instr ) case opcode: instr(); break;
 
-void Cpu::initialize()
+// a switch lets the compiler inline the address mode templates into each case
+void Cpu::executeOpcode( Byte opcode )
 {
-	for ( size_t i = 0; i < 0x100; ++i )
+	switch ( opcode )
 	{
-		SET_IMPLIED( i, illegalOpcode )
-	}
+		CPU_OPERATIONS( CASE_ADDRMODE_OP, CASE_IMPLIED, CASE_IMPLIED )
 
-	SET_ADDRMODE_OP( 0x69, addWithCarry, Immediate )
-	SET_ADDRMODE_OP( 0x65, addWithCarry, ZeroPage )
-	SET_ADDRMODE_OP( 0x75, addWithCarry, ZeroPageX )
-	SET_ADDRMODE_OP( 0x6d, addWithCarry, Absolute )
-	SET_ADDRMODE_OP( 0x7d, addWithCarry, AbsoluteX )
-	SET_ADDRMODE_OP( 0x79, addWithCarry, AbsoluteY )
-	SET_ADDRMODE_OP( 0x61, addWithCarry, IndirectX )
-	SET_ADDRMODE_OP( 0x71, addWithCarry, IndirectY )
-
-	SET_ADDRMODE_OP( 0x29, bitwiseAnd, Immediate )
-	SET_ADDRMODE_OP( 0x25, bitwiseAnd, ZeroPage )
-	SET_ADDRMODE_OP( 0x35, bitwiseAnd, ZeroPageX )
-	SET_ADDRMODE_OP( 0x2d, bitwiseAnd, Absolute )
-	SET_ADDRMODE_OP( 0x3d, bitwiseAnd, AbsoluteX )
-	SET_ADDRMODE_OP( 0x39, bitwiseAnd, AbsoluteY )
-	SET_ADDRMODE_OP( 0x21, bitwiseAnd, IndirectX )
-	SET_ADDRMODE_OP( 0x31, bitwiseAnd, IndirectY )
-
-	SET_ADDRMODE_OP( 0x0a, shiftLeft, Accumulator )
-	SET_ADDRMODE_OP( 0x06, shiftLeft, ZeroPage )
-	SET_ADDRMODE_OP( 0x16, shiftLeft, ZeroPageX )
-	SET_ADDRMODE_OP( 0x0e, shiftLeft, Absolute )
-	SET_ADDRMODE_OP( 0x1e, shiftLeft, AbsoluteXStore )
-
-	SET_BRANCH( 0x90, branchOnCarryClear )
-	SET_BRANCH( 0xb0, branchOnCarrySet )
-	SET_BRANCH( 0xf0, branchOnZero )
-
-	SET_ADDRMODE_OP( 0x24, testBits, ZeroPage )
-	SET_ADDRMODE_OP( 0x2c, testBits, Absolute )
-
-	SET_BRANCH( 0x30, branchOnNegative )
-	SET_BRANCH( 0xd0, branchOnNotZero )
-	SET_BRANCH( 0x10, branchOnPositive )
-
-	SET_IMPLIED( 0x00, forceBreak )
-
-	SET_BRANCH( 0x50, branchOnOverflowClear )
-	SET_BRANCH( 0x70, branchOnOverflowSet )
-
-	SET_IMPLIED( 0x18, clearCarryFlag )
-	SET_IMPLIED( 0xd8, clearDecimalFlag )
-	SET_IMPLIED( 0x58, clearInterruptDisableFlag )
-	SET_IMPLIED( 0xb8, clearOverflowFlag )
-
-	SET_ADDRMODE_OP( 0xc9, compareWithAcc, Immediate )
-	SET_ADDRMODE_OP( 0xc5, compareWithAcc, ZeroPage )
-	SET_ADDRMODE_OP( 0xd5, compareWithAcc, ZeroPageX )
-	SET_ADDRMODE_OP( 0xcd, compareWithAcc, Absolute )
-	SET_ADDRMODE_OP( 0xdd, compareWithAcc, AbsoluteX )
-	SET_ADDRMODE_OP( 0xd9, compareWithAcc, AbsoluteY )
-	SET_ADDRMODE_OP( 0xc1, compareWithAcc, IndirectX )
-	SET_ADDRMODE_OP( 0xd1, compareWithAcc, IndirectY )
-
-	SET_ADDRMODE_OP( 0xe0, compareWithX, Immediate )
-	SET_ADDRMODE_OP( 0xe4, compareWithX, ZeroPage )
-	SET_ADDRMODE_OP( 0xec, compareWithX, Absolute )
-
-	SET_ADDRMODE_OP( 0xc0, compareWithY, Immediate )
-	SET_ADDRMODE_OP( 0xc4, compareWithY, ZeroPage )
-	SET_ADDRMODE_OP( 0xcc, compareWithY, Absolute )
-
-	SET_ADDRMODE_OP( 0xc6, decrement, ZeroPage )
-	SET_ADDRMODE_OP( 0xd6, decrement, ZeroPageX )
-	SET_ADDRMODE_OP( 0xce, decrement, Absolute )
-	SET_ADDRMODE_OP( 0xde, decrement, AbsoluteXStore )
-
-	SET_IMPLIED( 0xca, decrementX )
-	SET_IMPLIED( 0x88, decrementY )
-
-	SET_ADDRMODE_OP( 0x49, exclusiveOr, Immediate )
-	SET_ADDRMODE_OP( 0x45, exclusiveOr, ZeroPage )
-	SET_ADDRMODE_OP( 0x55, exclusiveOr, ZeroPageX )
-	SET_ADDRMODE_OP( 0x4d, exclusiveOr, Absolute )
-	SET_ADDRMODE_OP( 0x5d, exclusiveOr, AbsoluteX )
-	SET_ADDRMODE_OP( 0x59, exclusiveOr, AbsoluteY )
-	SET_ADDRMODE_OP( 0x41, exclusiveOr, IndirectX )
-	SET_ADDRMODE_OP( 0x51, exclusiveOr, IndirectY )
-
-	SET_ADDRMODE_OP( 0xe6, increment, ZeroPage )
-	SET_ADDRMODE_OP( 0xf6, increment, ZeroPageX )
-	SET_ADDRMODE_OP( 0xee, increment, Absolute )
-	SET_ADDRMODE_OP( 0xfe, increment, AbsoluteXStore )
-
-	SET_IMPLIED( 0xe8, incrementX )
-	SET_IMPLIED( 0xc8, incrementY )
-
-	SET_ADDRMODE_OP( 0x4c, jump, Absolute )
-	SET_ADDRMODE_OP( 0x6c, jump, Indirect )
-
-	SET_ADDRMODE_OP( 0x20, jumpToSubroutine, Absolute )
-
-	SET_ADDRMODE_OP( 0xa9, loadAcc, Immediate )
-	SET_ADDRMODE_OP( 0xa5, loadAcc, ZeroPage )
-	SET_ADDRMODE_OP( 0xb5, loadAcc, ZeroPageX )
-	SET_ADDRMODE_OP( 0xad, loadAcc, Absolute )
-	SET_ADDRMODE_OP( 0xbd, loadAcc, AbsoluteX )
-	SET_ADDRMODE_OP( 0xb9, loadAcc, AbsoluteY )
-	SET_ADDRMODE_OP( 0xa1, loadAcc, IndirectX )
-	SET_ADDRMODE_OP( 0xb1, loadAcc, IndirectY )
-
-	SET_ADDRMODE_OP( 0xa2, loadX, Immediate )
-	SET_ADDRMODE_OP( 0xa6, loadX, ZeroPage )
-	SET_ADDRMODE_OP( 0xb6, loadX, ZeroPageY )
-	SET_ADDRMODE_OP( 0xae, loadX, Absolute )
-	SET_ADDRMODE_OP( 0xbe, loadX, AbsoluteY )
-
-	SET_ADDRMODE_OP( 0xa0, loadY, Immediate );
-	SET_ADDRMODE_OP( 0xa4, loadY, ZeroPage );
-	SET_ADDRMODE_OP( 0xb4, loadY, ZeroPageX );
-	SET_ADDRMODE_OP( 0xac, loadY, Absolute );
-	SET_ADDRMODE_OP( 0xbc, loadY, AbsoluteX );
-
-	SET_ADDRMODE_OP( 0x4a, shiftRight, Accumulator );
-	SET_ADDRMODE_OP( 0x46, shiftRight, ZeroPage );
-	SET_ADDRMODE_OP( 0x56, shiftRight, ZeroPageX );
-	SET_ADDRMODE_OP( 0x4e, shiftRight, Absolute );
-	SET_ADDRMODE_OP( 0x5e, shiftRight, AbsoluteXStore );
-
-	SET_IMPLIED( 0xea, noOperation );
-
-	SET_ADDRMODE_OP( 0x09, bitwiseOr, Immediate );
-	SET_ADDRMODE_OP( 0x05, bitwiseOr, ZeroPage );
-	SET_ADDRMODE_OP( 0x15, bitwiseOr, ZeroPageX );
-	SET_ADDRMODE_OP( 0x0d, bitwiseOr, Absolute );
-	SET_ADDRMODE_OP( 0x1d, bitwiseOr, AbsoluteX );
-	SET_ADDRMODE_OP( 0x19, bitwiseOr, AbsoluteY );
-	SET_ADDRMODE_OP( 0x01, bitwiseOr, IndirectX );
-	SET_ADDRMODE_OP( 0x11, bitwiseOr, IndirectY );
-
-	SET_IMPLIED( 0x48, pushAcc );
-	SET_IMPLIED( 0x08, pushStatus );
-	SET_IMPLIED( 0x68, popAcc );
-	SET_IMPLIED( 0x28, popStatus );
-
-	SET_ADDRMODE_OP( 0x2a, rotateLeft, Accumulator );
-	SET_ADDRMODE_OP( 0x26, rotateLeft, ZeroPage );
-	SET_ADDRMODE_OP( 0x36, rotateLeft, ZeroPageX );
-	SET_ADDRMODE_OP( 0x2e, rotateLeft, Absolute );
-	SET_ADDRMODE_OP( 0x3e, rotateLeft, AbsoluteXStore );
-
-	SET_ADDRMODE_OP( 0x6a, rotateRight, Accumulator );
-	SET_ADDRMODE_OP( 0x66, rotateRight, ZeroPage );
-	SET_ADDRMODE_OP( 0x76, rotateRight, ZeroPageX );
-	SET_ADDRMODE_OP( 0x6e, rotateRight, Absolute );
-	SET_ADDRMODE_OP( 0x7e, rotateRight, AbsoluteXStore );
-
-	SET_IMPLIED( 0x40, returnFromInterrupt );
-
-	SET_IMPLIED( 0x60, returnFromSubroutine );
-
-	SET_ADDRMODE_OP( 0xe9, subtractFromAcc, Immediate );
-	SET_ADDRMODE_OP( 0xe5, subtractFromAcc, ZeroPage );
-	SET_ADDRMODE_OP( 0xf5, subtractFromAcc, ZeroPageX );
-	SET_ADDRMODE_OP( 0xed, subtractFromAcc, Absolute );
-	SET_ADDRMODE_OP( 0xfd, subtractFromAcc, AbsoluteX );
-	SET_ADDRMODE_OP( 0xf9, subtractFromAcc, AbsoluteY );
-	SET_ADDRMODE_OP( 0xe1, subtractFromAcc, IndirectX );
-	SET_ADDRMODE_OP( 0xf1, subtractFromAcc, IndirectY );
-
-	SET_IMPLIED( 0x38, setCarryFlag );
-	SET_IMPLIED( 0xf8, setDecimalFlag );
-	SET_IMPLIED( 0x78, setInterruptDisableFlag );
-
-	SET_ADDRMODE_OP( 0x85, storeAcc, ZeroPage );
-	SET_ADDRMODE_OP( 0x95, storeAcc, ZeroPageX );
-	SET_ADDRMODE_OP( 0x8d, storeAcc, Absolute );
-	SET_ADDRMODE_OP( 0x9d, storeAcc, AbsoluteXStore );
-	SET_ADDRMODE_OP( 0x99, storeAcc, AbsoluteYStore );
-	SET_ADDRMODE_OP( 0x81, storeAcc, IndirectX );
-	SET_ADDRMODE_OP( 0x91, storeAcc, IndirectYStore );
-
-	SET_ADDRMODE_OP( 0x86, storeX, ZeroPage );
-	SET_ADDRMODE_OP( 0x96, storeX, ZeroPageY );
-	SET_ADDRMODE_OP( 0x8e, storeX, Absolute );
-
-	SET_ADDRMODE_OP( 0x84, storeY, ZeroPage );
-	SET_ADDRMODE_OP( 0x94, storeY, ZeroPageX );
-	SET_ADDRMODE_OP( 0x8c, storeY, Absolute );
-
-	SET_IMPLIED( 0xaa, transferAccToX );
-	SET_IMPLIED( 0xa8, transferAccToY );
-	SET_IMPLIED( 0xba, transferStackPointerToX );
-	SET_IMPLIED( 0x8a, transferXToAcc );
-	SET_IMPLIED( 0x9a, transferXToStackPointer );
-	SET_IMPLIED( 0x98, transferYToAcc );
-
-	// unofficial:
-
-	SET_ADDRMODE_OP( 0x4b, andShiftRight, Immediate );
-
-	SET_ADDRMODE_OP( 0x0b, andSetCarry, Immediate );
-	SET_ADDRMODE_OP( 0x2b, andSetCarry, Immediate );
-
-	SET_ADDRMODE_OP( 0x6b, andRotateRight, Immediate );
-
-	SET_ADDRMODE_OP( 0xcb, subtractFromAccAndX, Immediate );
-
-	SET_ADDRMODE_OP( 0xa3, loadAccTransferToX, IndirectX )
-	SET_ADDRMODE_OP( 0xa7, loadAccTransferToX, ZeroPage )
-	SET_ADDRMODE_OP( 0xab, loadAccTransferToX, Immediate )
-	SET_ADDRMODE_OP( 0xaf, loadAccTransferToX, Absolute )
-	SET_ADDRMODE_OP( 0xb3, loadAccTransferToX, IndirectY )
-	SET_ADDRMODE_OP( 0xb7, loadAccTransferToX, ZeroPageY )
-	SET_ADDRMODE_OP( 0xbf, loadAccTransferToX, AbsoluteY )
-
-	SET_ADDRMODE_OP( 0x83, storeAccAndX, IndirectX )
-	SET_ADDRMODE_OP( 0x87, storeAccAndX, ZeroPage )
-	SET_ADDRMODE_OP( 0x8f, storeAccAndX, Absolute )
-	SET_ADDRMODE_OP( 0x97, storeAccAndX, ZeroPageY )
-
-	SET_ADDRMODE_OP( 0xc3, decrementCompare, IndirectX )
-	SET_ADDRMODE_OP( 0xc7, decrementCompare, ZeroPage )
-	SET_ADDRMODE_OP( 0xcf, decrementCompare, Absolute )
-	SET_ADDRMODE_OP( 0xd3, decrementCompare, IndirectYStore )
-	SET_ADDRMODE_OP( 0xd7, decrementCompare, ZeroPageX )
-	SET_ADDRMODE_OP( 0xdb, decrementCompare, AbsoluteYStore )
-	SET_ADDRMODE_OP( 0xdf, decrementCompare, AbsoluteXStore )
-
-	SET_ADDRMODE_OP( 0xe3, incrementSubtract, IndirectX )
-	SET_ADDRMODE_OP( 0xe7, incrementSubtract, ZeroPage )
-	SET_ADDRMODE_OP( 0xef, incrementSubtract, Absolute )
-	SET_ADDRMODE_OP( 0xf3, incrementSubtract, IndirectYStore )
-	SET_ADDRMODE_OP( 0xf7, incrementSubtract, ZeroPageX )
-	SET_ADDRMODE_OP( 0xfb, incrementSubtract, AbsoluteYStore )
-	SET_ADDRMODE_OP( 0xff, incrementSubtract, AbsoluteXStore )
-
-	SET_ADDRMODE_OP( 0x23, rotateLeftAnd, IndirectX )
-	SET_ADDRMODE_OP( 0x27, rotateLeftAnd, ZeroPage )
-	SET_ADDRMODE_OP( 0x2f, rotateLeftAnd, Absolute )
-	SET_ADDRMODE_OP( 0x33, rotateLeftAnd, IndirectYStore )
-	SET_ADDRMODE_OP( 0x37, rotateLeftAnd, ZeroPageX )
-	SET_ADDRMODE_OP( 0x3b, rotateLeftAnd, AbsoluteYStore )
-	SET_ADDRMODE_OP( 0x3f, rotateLeftAnd, AbsoluteXStore )
-
-	SET_ADDRMODE_OP( 0x63, rotateRightAdd, IndirectX )
-	SET_ADDRMODE_OP( 0x67, rotateRightAdd, ZeroPage )
-	SET_ADDRMODE_OP( 0x6f, rotateRightAdd, Absolute )
-	SET_ADDRMODE_OP( 0x73, rotateRightAdd, IndirectYStore )
-	SET_ADDRMODE_OP( 0x77, rotateRightAdd, ZeroPageX )
-	SET_ADDRMODE_OP( 0x7b, rotateRightAdd, AbsoluteYStore )
-	SET_ADDRMODE_OP( 0x7f, rotateRightAdd, AbsoluteXStore )
-
-	SET_ADDRMODE_OP( 0x03, shiftLeftOrAcc, IndirectX )
-	SET_ADDRMODE_OP( 0x07, shiftLeftOrAcc, ZeroPage )
-	SET_ADDRMODE_OP( 0x0f, shiftLeftOrAcc, Absolute )
-	SET_ADDRMODE_OP( 0x13, shiftLeftOrAcc, IndirectYStore )
-	SET_ADDRMODE_OP( 0x17, shiftLeftOrAcc, ZeroPageX )
-	SET_ADDRMODE_OP( 0x1b, shiftLeftOrAcc, AbsoluteYStore )
-	SET_ADDRMODE_OP( 0x1f, shiftLeftOrAcc, AbsoluteXStore )
-
-	SET_ADDRMODE_OP( 0x43, shiftRightExclusiveOr, IndirectX )
-	SET_ADDRMODE_OP( 0x47, shiftRightExclusiveOr, ZeroPage )
-	SET_ADDRMODE_OP( 0x4f, shiftRightExclusiveOr, Absolute )
-	SET_ADDRMODE_OP( 0x53, shiftRightExclusiveOr, IndirectYStore )
-	SET_ADDRMODE_OP( 0x57, shiftRightExclusiveOr, ZeroPageX )
-	SET_ADDRMODE_OP( 0x5b, shiftRightExclusiveOr, AbsoluteYStore )
-	SET_ADDRMODE_OP( 0x5f, shiftRightExclusiveOr, AbsoluteXStore )
-
-	SET_ADDRMODE_OP( 0xeb, subtractFromAcc, Immediate )
-
-	SET_ADDRMODE_OP( 0x8b, transferXToAccAnd, Immediate )
-
-	SET_IMPLIED( 0x9e, andXAddrHigh )
-	SET_IMPLIED( 0x9c, andYAddrHigh )
-
-	SET_ADDRMODE_OP( 0x9b, andXAccStoreStackPointer, AbsoluteYStore )
-
-	SET_ADDRMODE_OP( 0x9f, andXAccSeven, AbsoluteYStore )
-	SET_ADDRMODE_OP( 0x93, andXAccSeven, IndirectYStore )
-
-	SET_ADDRMODE_OP( 0xbb, andSPTransferToAcXSP, AbsoluteY );
-
-	SET_IMPLIED( 0x1a, noOperation )
-	SET_IMPLIED( 0x3a, noOperation )
-	SET_IMPLIED( 0x5a, noOperation )
-	SET_IMPLIED( 0x7a, noOperation )
-	SET_IMPLIED( 0xda, noOperation )
-	SET_IMPLIED( 0xfa, noOperation )
-
-	SET_ADDRMODE_OP( 0x0c, ignoreByte, Absolute )
-	SET_ADDRMODE_OP( 0x1c, ignoreByte, AbsoluteX )
-	SET_ADDRMODE_OP( 0x3c, ignoreByte, AbsoluteX )
-	SET_ADDRMODE_OP( 0x5c, ignoreByte, AbsoluteX )
-	SET_ADDRMODE_OP( 0x7c, ignoreByte, AbsoluteX )
-	SET_ADDRMODE_OP( 0xdc, ignoreByte, AbsoluteX )
-	SET_ADDRMODE_OP( 0xfc, ignoreByte, AbsoluteX )
-	SET_ADDRMODE_OP( 0x04, ignoreByte, ZeroPage )
-	SET_ADDRMODE_OP( 0x14, ignoreByte, ZeroPageX )
-	SET_ADDRMODE_OP( 0x34, ignoreByte, ZeroPageX )
-	SET_ADDRMODE_OP( 0x44, ignoreByte, ZeroPage )
-	SET_ADDRMODE_OP( 0x54, ignoreByte, ZeroPageX )
-	SET_ADDRMODE_OP( 0x64, ignoreByte, ZeroPage )
-	SET_ADDRMODE_OP( 0x74, ignoreByte, ZeroPageX )
-	SET_ADDRMODE_OP( 0x80, ignoreByte, Immediate )
-	SET_ADDRMODE_OP( 0x82, ignoreByte, Immediate )
-	SET_ADDRMODE_OP( 0x89, ignoreByte, Immediate )
-	SET_ADDRMODE_OP( 0xc2, ignoreByte, Immediate )
-	SET_ADDRMODE_OP( 0xd4, ignoreByte, ZeroPageX )
-	SET_ADDRMODE_OP( 0xe2, ignoreByte, Immediate )
-	SET_ADDRMODE_OP( 0xf4, ignoreByte, ZeroPageX )
+		default:
+			illegalOpcode();
+			break;
+	}
 }
 
+#undef CASE_ADDRMODE_OP
+#undef CASE_IMPLIED
+
+#else
+
+#define SET_ADDRMODE_OP( opcode, instr, addrmode ) table[ opcode ] = &Cpu::instr< AddressMode::addrmode >;
+#define SET_IMPLIED( opcode, instr ) table[ opcode ] = &Cpu::instr;
+
+constexpr std::array<Cpu::Operation, 0x100> Cpu::s_operations = []
+{
+	std::array<Operation, 0x100> table{};
+	for ( auto& func : table )
+		func = &Cpu::illegalOpcode;
+
+	CPU_OPERATIONS( SET_ADDRMODE_OP, SET_IMPLIED, SET_IMPLIED )
+	return table;
+}();
+
 #undef SET_ADDRMODE_OP
 #undef SET_IMPLIED
-#undef SET_BRANCH
-
-#define writeBytes( var ) out.write( ( const char* )&var, sizeof( var ) );
-#define readBytes( var ) in.read( ( char* )&var, sizeof( var ) );
-
-void Cpu::saveState( std::ostream& out ) const
-{
-	writeBytes( m_ram );
-	writeBytes( m_cycles );
-	writeBytes( m_nmi );
-	writeBytes( m_irq );
-	writeBytes( m_programCounter );
-	writeBytes( m_accumulator );
-	writeBytes( m_xRegister );
-	writeBytes( m_yRegister );
-	writeBytes( m_stackPointer );
-	writeBytes( m_status );
-	writeBytes( m_oddCycle );
-	writeBytes( m_halt );
-}
-
-void Cpu::loadState( std::istream& in )
-{
-	readBytes( m_ram );
-	readBytes( m_cycles );
-	readBytes( m_nmi );
-	readBytes( m_irq );
-	readBytes( m_programCounter );
-	readBytes( m_accumulator );
-	readBytes( m_xRegister );
-	readBytes( m_yRegister );
-	readBytes( m_stackPointer );
-	readBytes( m_status );
-	readBytes( m_oddCycle );
-	readBytes( m_halt );
-}
-
-#undef writeBytes
-#undef readBytes
+
+void Cpu::executeOpcode( Byte opcode )
+{
+	( this->*s_operations[ opcode ] )();
+}
+
+#endif
+
+#define SET_DECODED_ADDRMODE_OP( opcode, instr, addrmode ) table[ opcode ] = &Cpu::instr< AddressMode::addrmode, true >;
+#define SET_DECODED_IMPLIED( opcode, instr ) table[ opcode ] = &Cpu::instr;
+#define SKIP_DECODED_BRANCH( opcode, instr )
+
+constexpr std::array<Cpu::Operation, 0x100> Cpu::s_decodedOperations = []
+{
+	std::array<Operation, 0x100> table{};
+	CPU_OPERATIONS( SET_DECODED_ADDRMODE_OP, SET_DECODED_IMPLIED, SKIP_DECODED_BRANCH )
+
+	// SYA and SXA read their operand like an undecoded absolute instruction
+	table[ 0x9c ] = nullptr;
+	table[ 0x9e ] = nullptr;
+	return table;
+}();
+
+#undef SET_DECODED_ADDRMODE_OP
+#undef SET_DECODED_IMPLIED
+#undef SKIP_DECODED_BRANCH
+
+void Cpu::saveState( ByteIO::Writer& writer ) const
+{
+	// interrupts are saved as PPU dots since they were raised
+	const int nmi = ( m_nmiTime >= 0 ) ? static_cast<int>( m_masterClock - m_nmiTime ) : -1;
+	const int irq = ( m_irqTime >= 0 ) ? static_cast<int>( m_masterClock - m_irqTime ) : -1;
+
+	writer.write( m_ram );
+	writer.write( m_cycles );
+	writer.write( nmi );
+	writer.write( irq );
+	writer.write( m_programCounter );
+	writer.write( m_accumulator );
+	writer.write( m_xRegister );
+	writer.write( m_yRegister );
+	writer.write( m_stackPointer );
+	writer.write( m_status );
+	writer.write( m_oddCycle );
+	writer.write( m_halt );
+}
+
+void Cpu::loadState( ByteIO::Reader& reader )
+{
+	int nmi = -1;
+	int irq = -1;
+
+	reader.read( m_ram );
+	reader.read( m_cycles );
+	reader.read( nmi );
+	reader.read( irq );
+	reader.read( m_programCounter );
+	reader.read( m_accumulator );
+	reader.read( m_xRegister );
+	reader.read( m_yRegister );
+	reader.read( m_stackPointer );
+	reader.read( m_status );
+	reader.read( m_oddCycle );
+	reader.read( m_halt );
+
+	m_nmiTime = ( nmi >= 0 ) ? m_masterClock - nmi : -1;
+	m_irqTime = ( irq >= 0 ) ? m_masterClock - irq : -1;
+	m_ppu->setClock( m_masterClock );
+	m_idleLoop = IdleLoop{};
+	invalidateAllRamCode();
+}
+
 
 enum ByteInterpretation
 {
@@ -1664,9 +1893,9 @@ void Cpu::dump( Word address )
 
 					case OPCODE:
 					{
-						auto operation = s_cpuOperations[ value ];
-						std::cout << ( ( operation.instr != Instruction::illegalOpcode )
-									   ? nes::getInstructionName( operation.instr )
+						const Opcode& opcode = OpcodeTable[ value ];
+						std::cout << ( ( opcode.instruction != Instruction::illegalOpcode )
+									   ? opcode.mnemonic
 									   : "   " );
 						break;
 					}
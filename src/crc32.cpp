@@ -1,6 +1,20 @@
 #include "crc32.hpp"
 
-const uint32_t crc_table[256] = {
+#include <array>
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+	#define CRC32_CLMUL
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define CRC32_CLMUL_TARGET
+	#else
+		#include <cpuid.h>
+		#define CRC32_CLMUL_TARGET __attribute__(( target( "sse4.1,pclmul" ) ))
+	#endif
+	#include <immintrin.h>
+#endif
+
+constexpr uint32_t crc_table[256] = {
     0x00000000UL, 0x77073096UL, 0xee0e612cUL, 0x990951baUL, 0x076dc419UL,
     0x706af48fUL, 0xe963a535UL, 0x9e6495a3UL, 0x0edb8832UL, 0x79dcb8a4UL,
     0xe0d5e91eUL, 0x97d2d988UL, 0x09b64c2bUL, 0x7eb17cbdUL, 0xe7b82d07UL,
@@ -55,14 +69,185 @@ const uint32_t crc_table[256] = {
     0x2d02ef8dUL
 };
 
-uint32_t crc32(const unsigned char* data, size_t size) {
-	uint32_t crc = 0xffffffff;
-    auto it = data;
-    auto end = data + size;
-	for( ; it != end; ++it )
-    {
-		size_t index = ( crc ^ *it ) & 0xff;
-		crc = ( crc >> 8 ) ^ crc_table[ index ];
+namespace
+{
+
+	// crc_slices[ k ][ n ] is the crc of byte n followed by k zero bytes, so 8 bytes can be looked up at once
+	using SliceTables = std::array<std::array<uint32_t, 256>, 8>;
+
+	constexpr SliceTables makeSliceTables()
+	{
+		SliceTables tables{};
+		for ( size_t n = 0; n < 256; ++n )
+			tables[ 0 ][ n ] = crc_table[ n ];
+
+		for ( size_t k = 1; k < 8; ++k )
+		{
+			for ( size_t n = 0; n < 256; ++n )
+			{
+				const uint32_t previous = tables[ k - 1 ][ n ];
+				tables[ k ][ n ] = ( previous >> 8 ) ^ crc_table[ previous & 0xff ];
+			}
+		}
+		return tables;
+	}
+
+	constexpr SliceTables crc_slices = makeSliceTables();
+
+	// little endian regardless of the host
+	uint32_t load32( const unsigned char* data )
+	{
+		return uint32_t( data[ 0 ] ) | ( uint32_t( data[ 1 ] ) << 8 ) | ( uint32_t( data[ 2 ] ) << 16 ) | ( uint32_t( data[ 3 ] ) << 24 );
+	}
+
+	uint32_t updateBytes( uint32_t crc, const unsigned char* data, size_t size )
+	{
+		for ( auto end = data + size; data != end; ++data )
+			crc = ( crc >> 8 ) ^ crc_table[ ( crc ^ *data ) & 0xff ];
+		return crc;
 	}
+
+	uint32_t updateSlicing8( uint32_t crc, const unsigned char* data, size_t size )
+	{
+		for ( ; size >= 8; data += 8, size -= 8 )
+		{
+			const uint32_t low = load32( data ) ^ crc;
+			const uint32_t high = load32( data + 4 );
+			crc = crc_slices[ 7 ][ low & 0xff ]
+				^ crc_slices[ 6 ][ ( low >> 8 ) & 0xff ]
+				^ crc_slices[ 5 ][ ( low >> 16 ) & 0xff ]
+				^ crc_slices[ 4 ][ low >> 24 ]
+				^ crc_slices[ 3 ][ high & 0xff ]
+				^ crc_slices[ 2 ][ ( high >> 8 ) & 0xff ]
+				^ crc_slices[ 1 ][ ( high >> 16 ) & 0xff ]
+				^ crc_slices[ 0 ][ high >> 24 ];
+		}
+		return updateBytes( crc, data, size );
+	}
+
+#ifdef CRC32_CLMUL
+
+	// CRC32C instruction of SSE 4.2 uses a different polynomial, so fold with carry-less multiplies instead
+	// constants and reduction from Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ"
+	constexpr size_t ClmulMinSize = 64;
+
+	CRC32_CLMUL_TARGET inline __m128i load( const unsigned char* data )
+	{
+		return _mm_loadu_si128( reinterpret_cast<const __m128i*>( data ) );
+	}
+
+	// multiply both halves of x by their fold constants and add the next block
+	CRC32_CLMUL_TARGET inline __m128i fold( __m128i x, __m128i k, __m128i next )
+	{
+		const __m128i lowProduct = _mm_clmulepi64_si128( x, k, 0x00 );
+		const __m128i highProduct = _mm_clmulepi64_si128( x, k, 0x11 );
+		return _mm_xor_si128( _mm_xor_si128( highProduct, lowProduct ), next );
+	}
+
+	// size must be at least ClmulMinSize and a multiple of 16
+	CRC32_CLMUL_TARGET uint32_t updateClmulBlocks( uint32_t crc, const unsigned char* data, size_t size )
+	{
+		const __m128i k1k2 = _mm_set_epi64x( 0x01c6e41596, 0x0154442bd4 );
+		const __m128i k3k4 = _mm_set_epi64x( 0x00ccaa009e, 0x01751997d0 );
+		const __m128i k5k0 = _mm_set_epi64x( 0, 0x0163cd6124 );
+		const __m128i poly = _mm_set_epi64x( 0x01f7011641, 0x01db710641 );
+		const __m128i low32 = _mm_setr_epi32( ~0, 0, ~0, 0 );
+
+		// four lanes of 16 bytes folded 64 bytes ahead
+		__m128i x1 = _mm_xor_si128( load( data ), _mm_cvtsi32_si128( static_cast<int>( crc ) ) );
+		__m128i x2 = load( data + 16 );
+		__m128i x3 = load( data + 32 );
+		__m128i x4 = load( data + 48 );
+		data += 64;
+		size -= 64;
+
+		for ( ; size >= 64; data += 64, size -= 64 )
+		{
+			x1 = fold( x1, k1k2, load( data ) );
+			x2 = fold( x2, k1k2, load( data + 16 ) );
+			x3 = fold( x3, k1k2, load( data + 32 ) );
+			x4 = fold( x4, k1k2, load( data + 48 ) );
+		}
+
+		// down to one lane, then the remaining 16 byte blocks
+		x1 = fold( x1, k3k4, x2 );
+		x1 = fold( x1, k3k4, x3 );
+		x1 = fold( x1, k3k4, x4 );
+
+		for ( ; size >= 16; data += 16, size -= 16 )
+			x1 = fold( x1, k3k4, load( data ) );
+
+		// 128 to 64 bits
+		__m128i x = _mm_xor_si128( _mm_srli_si128( x1, 8 ), _mm_clmulepi64_si128( x1, k3k4, 0x10 ) );
+		x = _mm_xor_si128( _mm_srli_si128( x, 4 ), _mm_clmulepi64_si128( _mm_and_si128( x, low32 ), k5k0, 0x00 ) );
+
+		// Barrett reduction to 32 bits
+		__m128i t = _mm_clmulepi64_si128( _mm_and_si128( x, low32 ), poly, 0x10 );
+		t = _mm_clmulepi64_si128( _mm_and_si128( t, low32 ), poly, 0x00 );
+		return static_cast<uint32_t>( _mm_extract_epi32( _mm_xor_si128( x, t ), 1 ) );
+	}
+
+	uint32_t updateClmul( uint32_t crc, const unsigned char* data, size_t size )
+	{
+		if ( size >= ClmulMinSize )
+		{
+			const size_t blocks = size & ~size_t( 15 );
+			crc = updateClmulBlocks( crc, data, blocks );
+			data += blocks;
+			size -= blocks;
+		}
+		return updateSlicing8( crc, data, size );
+	}
+
+	bool hasClmul()
+	{
+		constexpr unsigned int Sse41Bit = 1u << 19;
+		constexpr unsigned int PclmulBit = 1u << 1;
+
+		unsigned int ecx = 0;
+	#ifdef _MSC_VER
+		int info[ 4 ] = {};
+		__cpuid( info, 1 );
+		ecx = static_cast<unsigned int>( info[ 2 ] );
+	#else
+		unsigned int eax, ebx, edx;
+		if ( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+			return false;
+	#endif
+		return ( ecx & Sse41Bit ) && ( ecx & PclmulBit );
+	}
+
+#endif
+
+	using UpdateFunction = uint32_t(*)( uint32_t, const unsigned char*, size_t );
+
+	UpdateFunction selectUpdate()
+	{
+	#ifdef CRC32_CLMUL
+		if ( hasClmul() )
+			return updateClmul;
+	#endif
+		return updateSlicing8;
+	}
+}
+
+uint32_t crc32Init()
+{
+	return 0xffffffff;
+}
+
+uint32_t crc32Update(uint32_t crc, const unsigned char* data, size_t size)
+{
+	static const UpdateFunction update = selectUpdate();
+	return update( crc, data, size );
+}
+
+uint32_t crc32Final(uint32_t crc)
+{
 	return crc ^ 0xffffffff;
-}
\ No newline at end of file
+}
+
+uint32_t crc32(const unsigned char* data, size_t size)
+{
+	return crc32Final( crc32Update( crc32Init(), data, size ) );
+}
@@ -11,6 +11,7 @@
 #include "message.hpp"
 
 #include <fstream>
+#include <vector>
 
 #include "SDL.h"
 #include "SDL_image.h"
@@ -130,6 +131,7 @@ void closeFile()
 	rom_filename = "";
 	save_filename = "";
 	Movie::clear();
+	rewind_buffer.clear();
 }
 
 void toggleRecording()
@@ -222,14 +224,17 @@ void loadMovie()
 
 void takeScreenshot()
 {
-	SDL_Surface* surface = SDL_CreateRGBSurface( 0, nes::Ppu::ScreenWidth, nes::Ppu::ScreenHeight,
-						   24, Pixel::r_mask, Pixel::g_mask, Pixel::b_mask, Pixel::a_mask );
-	surface->pixels = const_cast<Pixel*>( s_nes.getPixelBuffer() );
+	std::vector<Pixel> pixels( nes::Ppu::ScreenWidth * nes::Ppu::ScreenHeight );
+	s_nes.getPixels( pixels.data() );
+
+	SDL_Surface* surface = SDL_CreateRGBSurfaceFrom( pixels.data(), nes::Ppu::ScreenWidth, nes::Ppu::ScreenHeight,
+						   24, nes::Ppu::ScreenWidth * sizeof( Pixel ), Pixel::r_mask, Pixel::g_mask, Pixel::b_mask, Pixel::a_mask );
 
 	int timestamp = (int)std::time( NULL );
 	std::string name = "screenshot_" + std::to_string( timestamp ) + ".png";
 	fs::path filename = screenshot_folder / name;
 	IMG_SavePNG( surface, filename.c_str() );
+	SDL_FreeSurface( surface );
 }
 
 void saveState( const std::string& filename )
@@ -272,7 +277,14 @@ void loadState( const std::string& filename )
 			}
 			if ( load )
 			{
-				s_nes.loadState( fin );
+				try
+				{
+					s_nes.loadState( fin );
+				}
+				catch ( const ByteIO::Exception& e )
+				{
+					showError( "Error", std::string( "Failed to load state: " ) + e.what() );
+				}
 			}
 			fin.close();
 		}
@@ -286,6 +298,35 @@ void loadState()
 	loadState( filename );
 }
 
+void startRewind()
+{
+	// movies depend on every frame being played in order
+	if ( rewinding || Movie::isPlaying() || Movie::isRecording() )
+		return;
+
+	rewinding = true;
+	s_nes.apu.setOutputSuppressed( true );
+}
+
+void stopRewind()
+{
+	if ( !rewinding )
+		return;
+
+	rewinding = false;
+	s_nes.apu.setOutputSuppressed( false );
+}
+
+void startFastForward()
+{
+	fast_forward = true;
+}
+
+void stopFastForward()
+{
+	fast_forward = false;
+}
+
 std::vector<Hotkey> hotkeys =
 {
 	{ SDLK_ESCAPE, quit },
@@ -297,7 +338,9 @@ std::vector<Hotkey> hotkeys =
 	{ SDLK_r, toggleRecording},
 	{ SDLK_a, togglePlayback},
 	{ SDLK_F5, saveState},
-	{ SDLK_F6, loadState}
+	{ SDLK_F6, loadState},
+	{ SDLK_BACKSPACE, startRewind, stopRewind },
+	{ SDLK_TAB, startFastForward, stopFastForward }
 };
 
 void pressHotkey( SDL_Keycode key )
@@ -309,4 +352,15 @@ void pressHotkey( SDL_Keycode key )
 			( *hotkeys[i].callback )();
 		}
 	}
+}
+
+void releaseHotkey( SDL_Keycode key )
+{
+	for ( int i = 0; i < ( int )hotkeys.size(); i++ )
+	{
+		if ( key == hotkeys[i].key && hotkeys[i].release != nullptr )
+		{
+			( *hotkeys[i].release )();
+		}
+	}
 }
\ No newline at end of file
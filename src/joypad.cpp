@@ -25,6 +25,7 @@ Joypad::Joypad()
 	{
 		buttons[n] = false;
 	}
+	current_button = 0;
 	strobe = false;
 }
 
@@ -69,19 +70,28 @@ void Joypad::releaseButton( Joypad::Button button )
 	setButtonState( button, false );
 }
 
-Joypad::Button Joypad::setKeyState( int key, bool pressed )
+Joypad::Button Joypad::getKeyButton( int key ) const
 {
 	for ( int n = 0; n < NUM_BUTTONS; n++ )
 	{
 		if ( keymap[n] == key )
 		{
-			buttons[n] = pressed;
 			return static_cast<Button>( n );
 		}
 	}
 	return NONE;
 }
 
+Joypad::Button Joypad::setKeyState( int key, bool pressed )
+{
+	Button button = getKeyButton( key );
+	if ( button != NONE )
+	{
+		buttons[button] = pressed;
+	}
+	return button;
+}
+
 Joypad::Button Joypad::pressKey( int key )
 {
 	return setKeyState( key, true );
@@ -2,32 +2,41 @@
 #include "main.hpp"
 
 #include "api.hpp"
-#include "Cartridge.hpp"
+#include "AudioRing.hpp"
+#include "cartridge.hpp"
 #include "config.hpp"
 #include "common.hpp"
 #include <stdx/assert.h>
 #include "filesystem.hpp"
 #include "globals.hpp"
 #include "hotkeys.hpp"
+#include "InputQueue.hpp"
 #include "joypad.hpp"
 #include "keyboard.hpp"
 #include "menu_bar.hpp"
 #include "menu_elements.hpp"
 #include "message.hpp"
 #include "movie.hpp"
-#include "nes.hpp"
+#include "Nes.hpp"
 #include "program_end.hpp"
 #include "rom_loader.hpp"
+#include "TripleBuffer.hpp"
 #include "zapper.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
 #include <string>
 #include <ctime>
 #include <cstdlib>
 #include <fstream>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 #include "SDL.h"
 
@@ -35,18 +44,24 @@
 SDL_Window* window = nullptr;
 SDL_Renderer* renderer = nullptr;
 SDL_Texture* nes_texture = nullptr;
+SDL_AudioDeviceID audio_device = 0;
 
 constexpr size_t ScreenWidth = nes::Ppu::ScreenWidth;
 constexpr size_t ScreenHeight = nes::Ppu::ScreenHeight;
 
 // NES
 nes::Nes s_nes;
-nes::Zapper zapper( s_nes.getPixelBuffer() );
+nes::Zapper zapper( s_nes.getFrameBuffer() );
 nes::Joypad joypad[ 4 ];
-bool paused = false;
+std::atomic<bool> paused{ false };
 bool step_frame = false;
 bool in_menu = false;
 bool muted = false;
+nes::RewindBuffer rewind_buffer;
+bool rewinding = false;
+bool fast_forward = false;
+int fast_forward_speed = 0;
+nes::AudioRing audio_ring;
 
 // paths
 fs::path rom_filename;
@@ -82,12 +97,27 @@ SDL_Rect crop_area =
 int window_width = ScreenWidth - DefaultCrop;
 int window_height = ScreenHeight - DefaultCrop;
 
+// emulator thread
+// everything but joypad input and finished frames is shared under emulation_mutex, held for each frame
+std::timed_mutex emulation_mutex;
+std::atomic<int> emulation_lock_waiters{ 0 };
+std::atomic<bool> emulation_running{ false };
+std::thread emulation_thread;
+nes::TripleBuffer<std::array<Pixel, ScreenWidth * ScreenHeight>> frame_buffer;
+nes::InputQueue input_queue;
+
+// errors hit on the emulator thread, SDL message boxes have to be shown from the main thread
+std::mutex emulation_error_mutex;
+std::string emulation_error;
+
 // frame timing
-const unsigned int TARGET_FPS = 60;
-const float TIME_PER_FRAME = 1000.0f / TARGET_FPS;
-int last_time = 0;
-int last_render_time = 0;
-float last_wait_time = 0;
+using FrameClock = std::chrono::steady_clock;
+const FrameClock::duration FRAME_PERIOD = std::chrono::duration_cast<FrameClock::duration>( std::chrono::duration<double>( 1.0 / nes::Nes::FrameRate ) );
+const int MAX_FRAME_CATCH_UP = 4;
+const double MAX_RATE_DEVIATION = 0.005;
+bool audio_rate_control = true;
+std::atomic<FrameClock::duration::rep> frame_period{ FRAME_PERIOD.count() };
+FrameClock::time_point last_frame_time;
 
 // frame rate
 int frame_number = 0;
@@ -99,10 +129,10 @@ float total_real_fps = 0;
 #define ave_real_fps ( total_real_fps / frame_number )
 
 #define FPS_COUNT 15
-float fps_count[FPS_COUNT];
+double fps_count[FPS_COUNT];
 std::string fps_text = "fps: 0";
 
-void addFPS( float fps )
+void addFPS( double fps )
 {
 	for ( int i = 0; i < FPS_COUNT - 1; i++ )
 	{
@@ -111,9 +141,9 @@ void addFPS( float fps )
 	fps_count[FPS_COUNT - 1] = fps;
 }
 
-float currentFPS()
+double currentFPS()
 {
-	float sum = 0;
+	double sum = 0;
 	for ( int i = 0; i < FPS_COUNT; i++ )
 	{
 		sum += fps_count[i];
@@ -132,10 +162,16 @@ void resetFrameNumber()
 
 bool loadFile( std::string filename )
 {
-	auto cartridge = nes::Rom::load( filename.c_str() );
-
-	if ( !cartridge )
+	std::unique_ptr<nes::Cartridge> cartridge;
+	try
+	{
+		cartridge = nes::Rom::load( filename.c_str() );
+	}
+	catch( const nes::Rom::LoadError& e )
+	{
+		showError( "Error", e.what() );
 		return false;
+	}
 
 	rom_filename = filename;
 	if ( cartridge->hasSRAM() )
@@ -151,6 +187,7 @@ bool loadFile( std::string filename )
 	s_nes.setCartridge( std::move( cartridge ) );
 	power();
 	Movie::clear();
+	rewind_buffer.clear();
 
 	return true;
 }
@@ -219,9 +256,17 @@ void cropScreen( int dx, int dy )
 	resizeWindow( w, h );
 }
 
+void stopEmulation();
+
 // guaranteed close program callback
 ProgramEnd pe( []
 {
+	stopEmulation();
+
+	// stop the callback before the audio ring is destroyed
+	if ( audio_device != 0 )
+		SDL_CloseAudioDevice( audio_device );
+
 	saveGame();
 	std::cout << "Goodbye!\n";
 } );
@@ -263,18 +308,42 @@ void keyboardEvent( const SDL_Event& event )
 
 		pressHotkey( key );
 	}
+	else
+	{
+		releaseHotkey( key );
+	}
+}
 
-	if ( !Movie::isPlaying() )
+// runs on the event thread, the emulator thread applies the input when the frame it happened before is due
+void queueJoypadInput( const SDL_Event& event )
+{
+	nes::InputEvent input;
+	input.time = FrameClock::now();
+	input.pressed = event.key.state == SDL_PRESSED;
+	for ( int i = 0; i < 4; i++ )
 	{
-		// get joypad input
-		for ( int i = 0; i < 4; i++ )
+		input.joypad = i;
+		input.button = joypad[i].getKeyButton( event.key.keysym.sym );
+		if ( input.button != nes::Joypad::NONE )
 		{
-			nes::Joypad::Button button = joypad[i].setKeyState( key, pressed );
+			input_queue.push( input );
+		}
+	}
+}
+
+void applyJoypadInput( FrameClock::time_point frame_time )
+{
+	nes::InputEvent input;
+	while ( input_queue.pop( input, frame_time ) )
+	{
+		if ( !Movie::isPlaying() )
+		{
+			joypad[input.joypad].setButtonState( input.button, input.pressed );
 
 			// record button press
-			if ( Movie::isRecording() && ( button != nes::Joypad::NONE ) )
+			if ( Movie::isRecording() )
 			{
-				Movie::recordButtonState( frame_number, i, button, pressed );
+				Movie::recordButtonState( frame_number, input.joypad, input.button, input.pressed );
 			}
 		}
 	}
@@ -288,6 +357,12 @@ void windowEvent( const SDL_Event& event )
 		case SDL_WINDOWEVENT_MAXIMIZED:
 		case SDL_WINDOWEVENT_RESTORED:
 			resizeRenderArea();
+			updateFramePacing();
+			break;
+
+		case SDL_WINDOWEVENT_MOVED:
+			// the window may be on a display with another refresh rate
+			updateFramePacing();
 			break;
 
 		case SDL_WINDOWEVENT_CLOSE:
@@ -348,6 +423,17 @@ void pollEvents()
 	SDL_Event event;
 	while ( SDL_PollEvent( &event ) )
 	{
+		if ( ( event.type == SDL_KEYDOWN || event.type == SDL_KEYUP ) && !event.key.repeat )
+		{
+			queueJoypadInput( event );
+		}
+
+		// anything else can change the emulator so wait for the current frame to finish
+		// the emulator thread backs off while someone is waiting, it would hog the lock when fast forwarding
+		emulation_lock_waiters++;
+		std::lock_guard<std::timed_mutex> lock( emulation_mutex );
+		emulation_lock_waiters--;
+
 		switch ( event.type )
 		{
 			case SDL_KEYDOWN:
@@ -389,15 +475,227 @@ void pollEvents()
 	}
 }
 
+// run at the display's refresh rate when it is within reach of the audio rate control so no frame is shown twice or dropped
+void updateFramePacing()
+{
+	SDL_RendererInfo info;
+	SDL_DisplayMode mode;
+	const bool display_locked = audio_rate_control
+		&& ( SDL_GetRendererInfo( renderer, &info ) == 0 ) && ( info.flags & SDL_RENDERER_PRESENTVSYNC )
+		&& ( SDL_GetCurrentDisplayMode( SDL_GetWindowDisplayIndex( window ), &mode ) == 0 ) && ( mode.refresh_rate > 0 )
+		&& ( std::abs( mode.refresh_rate / nes::Nes::FrameRate - 1 ) < MAX_RATE_DEVIATION );
+
+	const FrameClock::duration period = display_locked
+		? std::chrono::duration_cast<FrameClock::duration>( std::chrono::duration<double>( 1.0 / mode.refresh_rate ) )
+		: FRAME_PERIOD;
+	frame_period = period.count();
+}
+
+// nudge the sample rate so the audio queue holds at the latency target instead of drifting into crackle or lag
+void updateAudioRate()
+{
+	double scale = 1;
+	const size_t target = audio_ring.getLatencyTarget();
+	if ( audio_rate_control && target > 0 )
+	{
+		const double fill = static_cast<double>( audio_ring.size() );
+		const double error = std::clamp( ( fill - target ) / target, -1.0, 1.0 );
+		scale = 1 + MAX_RATE_DEVIATION * error;
+	}
+	s_nes.setAudioClockRateScale( scale );
+}
+
+// frames that won't be shown keep exact timing but draw nothing and make no sound
+void emulateFrame( bool output )
+{
+	s_nes.setRenderOutput( output );
+	if ( !output )
+	{
+		s_nes.apu.setOutputSuppressed( true );
+	}
+
+	if ( rewinding )
+	{
+		// run the restored frame so it is displayed, audio stays suppressed while rewinding
+		if ( ( s_nes.cartridge != nullptr ) && rewind_buffer.pop( s_nes ) )
+		{
+			s_nes.runFrame();
+		}
+	}
+	else if ( ( !paused || step_frame ) && ( s_nes.cartridge != nullptr ) && !s_nes.halted() )
+	{
+		if ( Movie::isPlaying() )
+		{
+			Movie::updateInput( frame_number );
+		}
+		else if ( !Movie::isRecording() )
+		{
+			rewind_buffer.push( s_nes );
+		}
+		updateAudioRate();
+		s_nes.runFrame();
+		zapper.update();
+
+		if ( s_nes.halted() )
+		{
+			std::stringstream ss;
+			ss << "The CPU encountered an illegal instruction at address " << std::hex << ( s_nes.cpu.getProgramCounter() - 1 );
+			s_nes.dump();
+
+			std::lock_guard<std::mutex> lock( emulation_error_mutex );
+			emulation_error = ss.str();
+		}
+		else
+		{
+			frame_number++;
+			const FrameClock::time_point now = FrameClock::now();
+			total_real_fps += static_cast<float>( 1.0 / std::chrono::duration<double>( now - last_frame_time ).count() );
+			last_frame_time = now;
+		}
+	}
+	step_frame = false;
+
+	if ( !output )
+	{
+		s_nes.apu.setOutputSuppressed( false );
+	}
+}
+
+// shown without holding emulation_mutex so the dialog never blocks the emulator thread
+void showEmulationError()
+{
+	std::string error;
+	{
+		std::lock_guard<std::mutex> lock( emulation_error_mutex );
+		error.swap( emulation_error );
+	}
+
+	if ( !error.empty() )
+	{
+		showError( "Error", error );
+	}
+}
+
+void emulationLoop()
+{
+	FrameClock::time_point next_frame_time = FrameClock::now();
+	FrameClock::time_point next_output_time = next_frame_time;
+	last_frame_time = next_frame_time;
+	while ( emulation_running )
+	{
+		const FrameClock::time_point now = FrameClock::now();
+		if ( now < next_frame_time )
+		{
+			std::this_thread::sleep_until( next_frame_time );
+			continue;
+		}
+
+		const FrameClock::duration period( frame_period.load() );
+		if ( now - next_frame_time > period * MAX_FRAME_CATCH_UP )
+		{
+			// too far behind to catch up, eg. after a modal dialog held the lock
+			next_frame_time = now;
+		}
+
+		while ( emulation_lock_waiters > 0 )
+		{
+			std::this_thread::yield();
+		}
+
+		// time out so a program ending while the event thread holds the lock can still stop this thread
+		std::unique_lock<std::timed_mutex> lock( emulation_mutex, std::defer_lock );
+		if ( !lock.try_lock_for( std::chrono::milliseconds( 10 ) ) )
+		{
+			continue;
+		}
+
+		// fast forward only shows and plays one frame per period, the rest are skipped
+		const bool fast = fast_forward;
+		const bool output = !fast || ( now >= next_output_time );
+
+		applyJoypadInput( next_frame_time );
+		emulateFrame( output );
+
+		// also published while paused so the window is redrawn
+		if ( output )
+		{
+			s_nes.getPixels( frame_buffer.getBack().data() );
+			frame_buffer.publish();
+			next_output_time = now + period;
+		}
+
+		lock.unlock();
+
+		if ( !fast )
+		{
+			next_frame_time += period;
+		}
+		else if ( fast_forward_speed > 0 )
+		{
+			next_frame_time += period / fast_forward_speed;
+		}
+		else
+		{
+			next_frame_time = now;
+		}
+	}
+}
+
+void startEmulation()
+{
+	emulation_running = true;
+	emulation_thread = std::thread( emulationLoop );
+}
+
+void stopEmulation()
+{
+	emulation_running = false;
+	if ( emulation_thread.joinable() )
+	{
+		emulation_thread.join();
+	}
+}
+
+// runs on SDL's audio thread
+void audioCallback( void*, Uint8* stream, int length )
+{
+	audio_ring.read( reinterpret_cast<blip_sample_t*>( stream ), static_cast<size_t>( length ) / sizeof( blip_sample_t ) );
+}
+
+void openAudio()
+{
+	// small device buffer, the ring's latency target absorbs frame jitter
+	SDL_AudioSpec spec{};
+	spec.freq = nes::Apu::SampleRate;
+	spec.format = AUDIO_S16SYS;
+	spec.channels = 1;
+	spec.samples = 512;
+	spec.callback = audioCallback;
+
+	audio_device = SDL_OpenAudioDevice( nullptr, 0, &spec, nullptr, 0 );
+	if ( audio_device == 0 )
+	{
+		dbLogError( "cannot open audio device: %s", SDL_GetError() );
+		return;
+	}
+
+	s_nes.setSampleOutput( []( const blip_sample_t* samples, size_t count )
+	{
+		audio_ring.write( samples, count );
+	} );
+
+	SDL_PauseAudioDevice( audio_device, 0 );
+}
+
 int main( int argc, char** argv )
 {
 	srand( (unsigned int)time( NULL ) );
 
-	nes::Cpu::initialize();
-
 	dbAssertMessage( SDL_Init( SDL_INIT_VIDEO | SDL_INIT_AUDIO ) == 0, "failed to initialize SDL" );
 
+	// the audio ring is sized by the config
 	loadConfig();
+	openAudio();
 
 	// create window
 	int window_flags = SDL_WINDOW_OPENGL | ( fullscreen ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0 );
@@ -436,58 +734,47 @@ int main( int argc, char** argv )
 
 	resizeWindow( window_width, window_height );
 
-	// run emulator
-	int last_time = SDL_GetTicks();
+	updateFramePacing();
+
+	// the emulator runs on its own thread, this one handles events and presents its frames
+	startEmulation();
+
+	FrameClock::time_point last_time = FrameClock::now();
 	while ( true )
 	{
 		pollEvents();
+		showEmulationError();
 
-		if ( ( !paused || step_frame ) && ( s_nes.cartridge != nullptr ) && !s_nes.halted() )
+		if ( !frame_buffer.update() )
 		{
-			if ( Movie::isPlaying() )
-			{
-				Movie::updateInput( frame_number );
-			}
-			s_nes.runFrame();
-			zapper.update();
-
-			if ( s_nes.halted() )
-			{
-				std::stringstream ss;
-				ss << "The CPU encountered an illegal instruction at address " << std::hex << ( s_nes.cpu.getProgramCounter() - 1 );
-				showError( "Error", ss.str() );
-				s_nes.dump();
-			}
-			else
-			{
-				frame_number++;
-				float elapsed = static_cast<float>( SDL_GetTicks() - last_time );
-				total_real_fps += 1000.0f / elapsed;
-			}
+			// nothing new to show, don't spin until the next frame is published
+			SDL_Delay( 1 );
+			continue;
 		}
-		step_frame = false;
 
 		// clear the screen
 		SDL_SetRenderDrawColor( renderer, 0, 0, 0, 255 ); // black
 		SDL_RenderClear( renderer );
 
 		// render nes & gui
-		SDL_UpdateTexture( nes_texture, nullptr, s_nes.getPixelBuffer(), ScreenWidth * sizeof ( Pixel ) );
+		SDL_UpdateTexture( nes_texture, nullptr, frame_buffer.getFront().data(), ScreenWidth * sizeof ( Pixel ) );
 		SDL_RenderCopy( renderer, nes_texture, &crop_area, &render_area );
 
 		// preset screen
 		SDL_RenderPresent( renderer );
 
-		int now = SDL_GetTicks();
+		const FrameClock::time_point now = FrameClock::now();
 		if ( !paused )
 		{
-			float elapsed = static_cast<float>( now - last_time );
-			float current_fps = 1000.0f / elapsed;
-			total_fps += current_fps;
+			const double current_fps = 1.0 / std::chrono::duration<double>( now - last_time ).count();
+			total_fps += static_cast<float>( current_fps );
 			addFPS( current_fps );
 
 			std::stringstream stream;
-			stream << std::fixed << std::setprecision( 1 ) << currentFPS();
+			stream << std::fixed << std::setprecision( 2 ) << currentFPS();
+			stream << " audio: " << ( audio_ring.size() * 1000 / nes::Apu::SampleRate ) << " ms";
+			stream << ", " << audio_ring.getUnderruns() << " underruns";
+			stream << ", " << audio_ring.getOverruns() << " overruns";
 			fps_text = "fps: " + stream.str();
 		}
 		last_time = now;
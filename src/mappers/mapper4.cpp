@@ -1,7 +1,7 @@
 
 #include "mappers/mapper4.hpp"
 
-#include "Cpu.hpp"
+#include "cpu.hpp"
 #include <stdx/assert.h>
 #include "main.hpp" // temp
 
@@ -62,7 +62,7 @@ void Mapper4::writePRG( Word address, Byte value )
 
 			case IRQ_DISABLE:
 				m_irqEnabled = false;
-				m_cpu->setIRQ( false );
+				getCPU()->setIRQ( false );
 				break;
 
 			case IRQ_ENABLE:
@@ -124,7 +124,7 @@ void Mapper4::signalScanline()
 
 	if ( m_irqEnabled && ( m_irqCounter == 0 ) )
 	{
-		m_cpu->setIRQ();
+		getCPU()->setIRQ();
 	}
 }
 
@@ -3,35 +3,24 @@
 
 #include <stdx/assert.h>
 #include "globals.hpp"
+#include "InputMovie.hpp"
 #include "menu_bar.hpp"
 
-#include <fstream>
-#include <iostream>
-#include <vector>
 #include <string>
 
 namespace Movie
 {
-	struct ButtonPress
-	{
-		int frame;
-		int joypad;
-		nes::Joypad::Button button;
-		bool pressed;
-	};
-
 	State state = NONE;
-	std::vector<ButtonPress> button_presses;
-	int index = 0;
+	nes::InputMovie movie;
 
 	bool empty()
 	{
-		return button_presses.empty();
+		return movie.empty();
 	}
 
 	void clear()
 	{
-		button_presses.clear();
+		movie.clear();
 		save_movie_button.disable();
 		play_movie_button.disable();
 
@@ -39,7 +28,6 @@ namespace Movie
 		load_movie_button.enable( cartridge != nullptr );
 		record_movie_button.enable( cartridge != nullptr );
 		state = NONE;
-		index = 0;
 	}
 
 	bool save( std::string filename )
@@ -49,27 +37,7 @@ namespace Movie
 			stopRecording();
 		}
 
-		std::ofstream fout( filename.c_str(), std::ios::binary );
-		if ( !fout.is_open() )
-		{
-			dbLogError( "cannot save move to %s", filename.c_str() );
-			return false;
-		}
-
-		unsigned int checksum = s_nes.getCartridge()->getChecksum();
-		writeBinary(fout, checksum);
-
-		int size = button_presses.size();
-		fout.write( ( char* )&size, sizeof( size ) );
-
-		for ( int i = 0; i < size; i++ )
-		{
-			ButtonPress press = button_presses[i];
-			fout.write( ( char* )&press, sizeof( press ) );
-		}
-
-		fout.close();
-		return true;
+		return movie.save( filename, s_nes.getCartridge()->getChecksum() );
 	}
 
 	bool load( std::string filename )
@@ -77,29 +45,17 @@ namespace Movie
 		stopRecording();
 		stopPlayback();
 
-		std::ifstream fin( filename.c_str(), std::ios::binary );
-		if ( !fin.is_open() )
-		{
-			dbLogError( "cannot open move from %s", filename.c_str() );
-			return false;
-		}
-
-		button_presses.clear();
-
-		int size;
-		fin.read( ( char* )&size, sizeof( size ) );
-
-		for ( int i = 0; i < size; i++ )
+		auto cartridge = s_nes.getCartridge();
+		bool loaded = movie.load( filename );
+		if ( loaded && ( !cartridge || movie.getChecksum() != cartridge->getChecksum() ) )
 		{
-			ButtonPress press;
-			fin.read( ( char* )&press, sizeof( press ) );
-			button_presses.push_back( press );
+			dbLogError( "movie %s was recorded with a different cartridge", filename.c_str() );
+			movie.clear();
+			loaded = false;
 		}
 
 		save_movie_button.enable( !empty() );
-		fin.close();
-
-		return true;
+		return loaded;
 	}
 
 	State getState()
@@ -111,7 +67,7 @@ namespace Movie
 	{
 		if ( state == NONE )
 		{
-			button_presses.clear();
+			movie.clear();
 			state = RECORDING;
 
 			save_movie_button.disable();
@@ -140,14 +96,14 @@ namespace Movie
 	void recordButtonState( int frame, int joypad, nes::Joypad::Button button, bool pressed )
 	{
 		dbAssertMessage( state == RECORDING, "cannot record button presses while not recording" );
-		button_presses.push_back( { frame, joypad, button, pressed } );
+		movie.record( frame, joypad, button, pressed );
 	}
 
 	void startPlayback()
 	{
 		if ( state == NONE && !empty() )
 		{
-			index = 0;
+			movie.rewind();
 			state = PLAYING;
 
 			play_movie_button.check();
@@ -173,28 +129,10 @@ namespace Movie
 
 	void updateInput( int frame )
 	{
-		while ( index < ( int )button_presses.size() )
-		{
-			const ButtonPress& press = button_presses[index];
-			if ( press.frame < frame )
-			{
-				index++;
-			}
-			else if ( press.frame == frame )
-			{
-				joypad[press.joypad].setButtonState( press.button, press.pressed );
-				index++;
-			}
-			else
-			{
-				break;
-			}
-		}
-
-		if ( index >= ( int )button_presses.size() )
+		if ( !movie.updateInput( frame, joypad, 4 ) )
 		{
 			// stop playback
 			state = NONE;
 		}
 	}
-}
\ No newline at end of file
+}
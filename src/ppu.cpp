@@ -1,7 +1,26 @@
 #include "ppu.hpp"
 
+#include "ByteIO.hpp"
 #include "cartridge.hpp"
 #include "cpu.hpp"
+#include "TileCache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+	#define PPU_SSSE3
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define PPU_SSSE3_TARGET
+	#else
+		#include <cpuid.h>
+		#define PPU_SSSE3_TARGET __attribute__(( target( "ssse3" ) ))
+	#endif
+	#include <immintrin.h>
+#endif
 
 using namespace nes;
 
@@ -25,6 +44,22 @@ namespace
 	The PPU makes no memory accesses during the VBLANK scanlines, so the PPU memory can be freely accessed by the program
 	*/
 	constexpr int NUM_CYCLES = 341;
+	constexpr int NUM_DOTS = NUM_SCANLINES * NUM_CYCLES;
+
+	// visible scanline cycles rendered in one go when nothing can write to the PPU in between
+	constexpr int SPAN_START_CYCLE = 2;
+	constexpr int SPAN_END_CYCLE = 255;
+	constexpr int SPAN_DOTS = SPAN_END_CYCLE - SPAN_START_CYCLE + 1;
+
+	constexpr int64_t NO_EVENT = std::numeric_limits<int64_t>::max();
+
+	// 0xff in every byte of the word that is not zero
+	inline uint64_t nonZeroBytes( uint64_t value )
+	{
+		constexpr uint64_t Low7 = 0x7f7f7f7f7f7f7f7f;
+		const uint64_t high = ( ( ( value & Low7 ) + Low7 ) | value ) & ~Low7;
+		return ( high >> 7 ) * 0xff;
+	}
 
 	constexpr int CHR_START = 0;
 	constexpr int CHR_END = 0x1fff;
@@ -35,7 +70,7 @@ namespace
 	constexpr int PALETTE_START = 0x3f00;
 	constexpr int PALETTE_END = 0x3fff;
 
-	const Pixel s_nesColourPalette[] =
+	constexpr Pixel s_nesColourPalette[] =
 	{
 		0x7C7C7C, 0x0000FC, 0x0000BC, 0x4428BC, 0x940084, 0xA80020, 0xA81000, 0x881400,
 		0x503000, 0x007800, 0x006800, 0x005800, 0x004058, 0x000000, 0x000000, 0x000000,
@@ -47,11 +82,152 @@ namespace
 		0xF8D878, 0xD8F878, 0xB8F8B8, 0xB8F8D8, 0x00FCFC, 0xF8D8F8, 0x000000, 0x000000
 	};
 
+	static_assert( std::size( s_nesColourPalette ) == 64 );
+	static_assert( sizeof( Pixel ) == 3, "frames are converted to packed RGB" );
+
+	void convertFrameScalar( const Byte* frame, Pixel* pixels, size_t count )
+	{
+		for( size_t i = 0; i < count; ++i )
+			pixels[ i ] = s_nesColourPalette[ frame[ i ] & 0x3f ];
+	}
+
+#ifdef PPU_SSSE3
+
+	// the palette split into one 64 byte table per channel, looked up 16 entries at a time with pshufb
+	using ChannelTables = std::array<std::array<Byte, 64>, 3>;
+
+	constexpr ChannelTables makeChannelTables()
+	{
+		ChannelTables tables{};
+		for( size_t i = 0; i < 64; ++i )
+		{
+			tables[ 0 ][ i ] = s_nesColourPalette[ i ].r;
+			tables[ 1 ][ i ] = s_nesColourPalette[ i ].g;
+			tables[ 2 ][ i ] = s_nesColourPalette[ i ].b;
+		}
+		return tables;
+	}
+
+	constexpr ChannelTables s_channelTables = makeChannelTables();
+
+	// shuffles that interleave 16 bytes of each channel into 48 bytes of packed RGB, 0x80 clears the byte
+	using InterleaveMasks = std::array<std::array<std::array<Byte, 16>, 3>, 3>;
+
+	constexpr InterleaveMasks makeInterleaveMasks()
+	{
+		InterleaveMasks masks{};
+		for( size_t block = 0; block < 3; ++block )
+		{
+			for( size_t channel = 0; channel < 3; ++channel )
+			{
+				for( size_t i = 0; i < 16; ++i )
+				{
+					const size_t byte = block * 16 + i;
+					masks[ block ][ channel ][ i ] = ( byte % 3 == channel ) ? static_cast<Byte>( byte / 3 ) : 0x80;
+				}
+			}
+		}
+		return masks;
+	}
+
+	constexpr InterleaveMasks s_interleaveMasks = makeInterleaveMasks();
+
+	PPU_SSSE3_TARGET inline __m128i loadBytes( const Byte* data )
+	{
+		return _mm_loadu_si128( reinterpret_cast<const __m128i*>( data ) );
+	}
+
+	// pshufb only indexes 16 bytes, so each channel is looked up in its four 16 byte quarters
+	// a selector keeps its lane's low nibble where the index is in the quarter and sets bit 7 to zero the lane elsewhere
+	PPU_SSSE3_TARGET inline __m128i lookupChannel( const Byte* table, const __m128i selectors[ 4 ] )
+	{
+		__m128i value = _mm_shuffle_epi8( loadBytes( table ), selectors[ 0 ] );
+		value = _mm_or_si128( value, _mm_shuffle_epi8( loadBytes( table + 16 ), selectors[ 1 ] ) );
+		value = _mm_or_si128( value, _mm_shuffle_epi8( loadBytes( table + 32 ), selectors[ 2 ] ) );
+		return _mm_or_si128( value, _mm_shuffle_epi8( loadBytes( table + 48 ), selectors[ 3 ] ) );
+	}
+
+	PPU_SSSE3_TARGET inline __m128i interleaveBlock( __m128i r, __m128i g, __m128i b, const InterleaveMasks::value_type& masks )
+	{
+		return _mm_or_si128( _mm_or_si128(
+			_mm_shuffle_epi8( r, loadBytes( masks[ 0 ].data() ) ),
+			_mm_shuffle_epi8( g, loadBytes( masks[ 1 ].data() ) ) ),
+			_mm_shuffle_epi8( b, loadBytes( masks[ 2 ].data() ) ) );
+	}
+
+	PPU_SSSE3_TARGET void convertFrameSsse3( const Byte* frame, Pixel* pixels, size_t count )
+	{
+		const __m128i indexMask = _mm_set1_epi8( 0x3f );
+		const __m128i selectorBias = _mm_set1_epi8( 0x70 );
+		Byte* out = reinterpret_cast<Byte*>( pixels );
+
+		size_t i = 0;
+		for( ; i + 16 <= count; i += 16, out += 48 )
+		{
+			const __m128i indices = _mm_and_si128( loadBytes( frame + i ), indexMask );
+
+			// 0 to 15 after the xor becomes 0x70 to 0x7f, anything larger saturates past 0x80
+			__m128i selectors[ 4 ];
+			for( int quarter = 0; quarter < 4; ++quarter )
+				selectors[ quarter ] = _mm_adds_epu8( _mm_xor_si128( indices, _mm_set1_epi8( static_cast<char>( quarter * 16 ) ) ), selectorBias );
+
+			const __m128i r = lookupChannel( s_channelTables[ 0 ].data(), selectors );
+			const __m128i g = lookupChannel( s_channelTables[ 1 ].data(), selectors );
+			const __m128i b = lookupChannel( s_channelTables[ 2 ].data(), selectors );
+
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( out ), interleaveBlock( r, g, b, s_interleaveMasks[ 0 ] ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( out + 16 ), interleaveBlock( r, g, b, s_interleaveMasks[ 1 ] ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( out + 32 ), interleaveBlock( r, g, b, s_interleaveMasks[ 2 ] ) );
+		}
+
+		convertFrameScalar( frame + i, pixels + i, count - i );
+	}
+
+	bool hasSsse3()
+	{
+		constexpr unsigned int Ssse3Bit = 1u << 9;
+
+		unsigned int ecx = 0;
+	#ifdef _MSC_VER
+		int info[ 4 ] = {};
+		__cpuid( info, 1 );
+		ecx = static_cast<unsigned int>( info[ 2 ] );
+	#else
+		unsigned int eax, ebx, edx;
+		if ( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+			return false;
+	#endif
+		return ( ecx & Ssse3Bit ) != 0;
+	}
+
+#endif
+
+	using ConvertFunction = void(*)( const Byte*, Pixel*, size_t );
+
+	ConvertFunction selectConvertFrame()
+	{
+	#ifdef PPU_SSSE3
+		if ( hasSsse3() )
+			return convertFrameSsse3;
+	#endif
+		return convertFrameScalar;
+	}
+
+	// palette index of black
+	constexpr Byte BLACK = 0x0f;
+
 	const Byte s_paletteRamBootValues[] = {
 		0x09, 0x01, 0x00, 0x01, 0x00, 0x02, 0x02, 0x0D, 0x08, 0x10, 0x08, 0x24, 0x00, 0x00, 0x04, 0x2C,
 		0x09, 0x01, 0x34, 0x03, 0x00, 0x04, 0x00, 0x14, 0x08, 0x3A, 0x00, 0x02, 0x00, 0x20, 0x2C, 0x08
 	};
 
+	// dots until the PPU next lands on the given scanline and cycle
+	inline int dotsUntil( int scanline, int cycle, int toScanline, int toCycle )
+	{
+		const int dots = ( toScanline - scanline ) * NUM_CYCLES + ( toCycle - cycle );
+		return ( dots > 0 ) ? dots : dots + NUM_DOTS;
+	}
+
 	template<typename INT>
 	inline bool getBit( INT mask, size_t bit )
 	{
@@ -122,14 +298,30 @@ inline Word Ppu::getBackgroundAddress()
 
 void Ppu::clearScreen()
 {
-	for( auto& pixel : m_pixels )
-		pixel = Pixel( 0, 0, 0 );
+	std::fill( std::begin( m_frameBuffer ), std::end( m_frameBuffer ), BLACK );
+}
+
+Pixel Ppu::getColour( Byte index )
+{
+	return s_nesColourPalette[ index & 0x3f ];
+}
+
+void Ppu::convertFrame( const Byte* frame, Pixel* pixels )
+{
+	static const ConvertFunction convert = selectConvertFrame();
+	convert( frame, pixels, ScreenWidth * ScreenHeight );
 }
 
 void Ppu::randomizeClockSync()
 {
+	// ticking fetches from the cartridge
+	if ( !m_cartridge )
+		return;
+
 	// clock can start in one of 4 different cpu synchronization alignments
-	for( int i = 0, end = rand() % 4; i < end; ++i )
+	const int alignment = ( m_clockSyncAlignment == ClockSyncRandom ) ? rand() % 4 : m_clockSyncAlignment;
+	dbAssert( 0 <= alignment && alignment < 4 );
+	for( int i = 0; i < alignment; ++i )
 		tick();
 }
 
@@ -153,16 +345,38 @@ void Ppu::power()
 	m_spriteZeroThisScanline = false;
 	m_spritesOnNextScanline = 0;
 	m_spritesOnThisScanline = 0;
+	buildSpriteLine();
 
 	for( auto& value : m_primaryOAM )
 		value = 0xff;
 
+	// cleared like cpu ram so powering on matches a new instance
+	m_nametable.fill( 0 );
+	m_secondaryOAM.fill( 0 );
+	m_spriteShiftLow.fill( 0 );
+	m_spriteShiftHigh.fill( 0 );
+	m_spriteXCounter.fill( 0 );
+	m_spriteAttributeLatch.fill( 0 );
+	m_readBuffer = 0;
+	m_bgLatchLow = 0;
+	m_bgLatchHigh = 0;
+	m_bgShiftLow = 0;
+	m_bgShiftHigh = 0;
+	m_attributeLatch = 0;
+	m_attributeLatchLow = false;
+	m_attributeLatchHigh = false;
+	m_attributeShiftLow = 0;
+	m_attributeShiftHigh = 0;
+	m_nametableLatch = 0;
+	m_spriteZeroHit = false;
+
 	static_assert( PALETTE_SIZE == std::size( s_paletteRamBootValues ) );
 	for( uint32_t i = 0; i < m_palette.size(); ++i )
 		m_palette[ i ] = s_paletteRamBootValues[ i ];
 
 	clearScreen();
 	randomizeClockSync();
+	updateNextEvent();
 }
 
 void Ppu::reset()
@@ -179,18 +393,11 @@ void Ppu::reset()
 	m_spriteZeroThisScanline = false;
 	m_spritesOnNextScanline = 0;
 	m_spritesOnThisScanline = 0;
+	buildSpriteLine();
 
 	clearScreen();
 	randomizeClockSync();
-}
-
-bool Ppu::readyToDraw()
-{
-	if ( !m_canDraw )
-		return false;
-
-	m_canDraw = false;
-	return true;
+	updateNextEvent();
 }
 
 Byte Ppu::readRegister( size_t reg )
@@ -259,10 +466,12 @@ void Ppu::writeRegister( size_t reg, Byte value )
 	{
 		case PpuRegister::Control:
 			writeToControl( value );
+			updateNextEvent();
 			break;
 
 		case PpuRegister::Mask:
 			m_mask = value;
+			updateNextEvent();
 			break;
 
 		case PpuRegister::OamAddress:
@@ -430,6 +639,152 @@ void Ppu::clearOAM()
 	*/
 }
 
+void Ppu::setCartridge( Cartridge* cartridge )
+{
+	m_cartridge = cartridge;
+	m_scanlineSignal = cartridge && ( cartridge->getPpuEvents() & Cartridge::ScanlineSignal );
+	updateNextEvent();
+}
+
+void Ppu::setClock( int64_t clock )
+{
+	m_clock = clock;
+	updateNextEvent();
+}
+
+void Ppu::runTo( int64_t clock )
+{
+	while ( m_clock < clock )
+	{
+		// vblank has nothing to do until the pre-render scanline
+		const int idleDots = static_cast<int>( std::min<int64_t>( getIdleDots(), clock - m_clock ) );
+		if ( idleDots > 0 )
+		{
+			const int dot = m_cycle + idleDots;
+			m_scanline += dot / NUM_CYCLES;
+			m_cycle = dot % NUM_CYCLES;
+			m_clock += idleDots;
+			continue;
+		}
+
+		// the CPU can't write to the PPU until the next sync, so the span can't contain raster effects
+		if ( m_cycle == SPAN_START_CYCLE - 1
+			&& m_scanline < ScreenHeight
+			&& renderingEnabled()
+			&& clock - m_clock >= SPAN_DOTS )
+		{
+			renderBackgroundSpan();
+			continue;
+		}
+
+		++m_clock;
+		tick();
+
+		if ( m_clock == m_scanlineSignalClock )
+		{
+			m_cartridge->signalScanline();
+			updateScanlineSignal();
+		}
+	}
+
+	updateNextEvent();
+}
+
+int Ppu::getIdleDots() const
+{
+	const int scanline = static_cast<int>( m_scanline );
+	const int cycle = static_cast<int>( m_cycle );
+
+	// idle until the vblank flag is set
+	if ( scanline == POSTRENDER_SCANLINE )
+		return NUM_CYCLES - cycle;
+
+	// idle until the last vblank dot
+	if ( ( scanline == VBLANK_SCANLINE && cycle >= 1 ) || ( VBLANK_SCANLINE < scanline && scanline < PRERENDER_SCANLINE ) )
+		return ( PRERENDER_SCANLINE - 1 - scanline ) * NUM_CYCLES + ( NUM_CYCLES - 1 - cycle );
+
+	return 0;
+}
+
+void Ppu::updateNextEvent()
+{
+	const int scanline = static_cast<int>( m_scanline );
+	const int cycle = static_cast<int>( m_cycle );
+
+	int dots = std::min( dotsUntil( scanline, cycle, POSTRENDER_SCANLINE, 0 ),
+		dotsUntil( scanline, cycle, VBLANK_SCANLINE, 1 ) );
+
+	updateScanlineSignal();
+	if ( m_scanlineSignalClock != NO_EVENT )
+		dots = std::min( dots, static_cast<int>( m_scanlineSignalClock - m_clock ) );
+
+	// the odd frame skipped dot can bring an event one dot closer
+	m_nextEventClock = m_clock + std::max( dots - 1, 1 );
+}
+
+int64_t Ppu::getStatusStableClock() const
+{
+	const int scanline = static_cast<int>( m_scanline );
+	const int cycle = static_cast<int>( m_cycle );
+
+	// the next read clears a set vblank flag
+	if ( testFlag( m_status, VBlank ) )
+		return m_clock;
+
+	// sprite flags can be set on any visible dot while rendering
+	const Byte spriteFlags = SpriteZeroHit | SpriteOverflow;
+	const bool spriteFlagsCanSet = renderingEnabled() && ( m_status & spriteFlags ) != spriteFlags;
+	if ( spriteFlagsCanSet && scanline < POSTRENDER_SCANLINE )
+		return m_clock;
+
+	// vblank is set on an event, every flag is cleared on the pre-render line
+	int dots = dotsUntil( scanline, cycle, PRERENDER_SCANLINE, 1 );
+	if ( spriteFlagsCanSet )
+		dots = std::min( dots, dotsUntil( scanline, cycle, 0, 0 ) );
+
+	return m_clock + std::max( dots - 1, 0 );
+}
+
+int Ppu::getDotsUntilScanlineSignal() const
+{
+	const int scanline = static_cast<int>( m_scanline );
+	const int cycle = static_cast<int>( m_cycle );
+	const bool renderScanline = ( scanline < POSTRENDER_SCANLINE ) || ( scanline == PRERENDER_SCANLINE );
+
+	int nextScanline;
+	if ( scanline < POSTRENDER_SCANLINE - 1 )
+		nextScanline = scanline + 1;
+	else if ( scanline < PRERENDER_SCANLINE )
+		nextScanline = PRERENDER_SCANLINE;
+	else
+		nextScanline = 0;
+
+	int dots = NUM_DOTS;
+	for ( int signalCycle : { 4, 260, 324 } )
+	{
+		if ( ( signalCycle == 260 ) == testFlag( m_control, BackgroundTileSelect ) )
+			continue;
+
+		const int signalScanline = ( renderScanline && cycle < signalCycle ) ? scanline : nextScanline;
+		int signalDots = dotsUntil( scanline, cycle, signalScanline, signalCycle );
+
+		// the first dot of odd frames is skipped while rendering
+		if ( scanline == PRERENDER_SCANLINE && signalScanline == 0 && !m_oddFrame )
+			--signalDots;
+
+		dots = std::min( dots, signalDots );
+	}
+	return dots;
+}
+
+// predicts the clock of the next A12 rise so it is delivered as an event instead of checked every dot
+void Ppu::updateScanlineSignal()
+{
+	m_scanlineSignalClock = ( m_scanlineSignal && renderingEnabled() )
+		? m_clock + getDotsUntilScanlineSignal()
+		: NO_EVENT;
+}
+
 void Ppu::tick()
 {
 	m_cycle = ( m_cycle + 1 ) % NUM_CYCLES;
@@ -541,24 +896,8 @@ void Ppu::scanlineCycle()
 					break;
 
 				case 4:
-				{
-					m_attributeLatch = read( m_renderAddress );
-					switch ( m_vramAddress & 0x42 )
-					{
-						case 0x02:
-							m_attributeLatch >>= 2;
-							break;
-
-						case 0x40:
-							m_attributeLatch >>= 4;
-							break;
-
-						case 0x42:
-							m_attributeLatch >>= 6;
-							break;
-					}
+					fetchAttribute();
 					break;
-				}
 
 				// background
 				case 5:
@@ -624,16 +963,128 @@ void Ppu::scanlineCycle()
 			}
 		}
 
-		// signal scanline to MMC3 cartridge
-		if ( renderingEnabled()
-			&& ( ( m_control & 0x10 )
-				? ( m_cycle == 324 || m_cycle == 4 )
-				: ( m_cycle == 260 ) ) )
+	}
+}
+
+void Ppu::fetchAttribute()
+{
+	m_attributeLatch = read( m_renderAddress );
+	switch ( m_vramAddress & 0x42 )
+	{
+		case 0x02:
+			m_attributeLatch >>= 2;
+			break;
+
+		case 0x40:
+			m_attributeLatch >>= 4;
+			break;
+
+		case 0x42:
+			m_attributeLatch >>= 6;
+			break;
+	}
+}
+
+// same result as ticking cycles 2 to 255 of a visible scanline with rendering enabled
+void Ppu::renderBackgroundSpan()
+{
+	const int64_t startClock = m_clock;
+
+	// a scanline signal at cycle 4 falls inside the span
+	const bool scanlineSignal = m_scanlineSignalClock <= startClock + SPAN_DOTS;
+	if ( scanlineSignal )
+	{
+		dbAssert( m_scanlineSignalClock == startClock + 4 - m_cycle );
+		m_clock = m_scanlineSignalClock;
+		m_cartridge->signalScanline();
+	}
+
+	const bool showBackground = testFlag( m_mask, ShowBackground );
+	const bool showBackgroundLeft8 = testFlag( m_mask, ShowBackgroundLeft8 );
+	const size_t attributeBit = 7 - m_fineXScroll;
+	const int fineShift = m_fineXScroll * 8;
+
+	// decoded tiles in the high and low bytes of the shift registers
+	uint64_t tilePixels = TileCache::decodeRow( m_bgShiftLow >> 8, m_bgShiftHigh >> 8 );
+	uint64_t nextTilePixels = TileCache::decodeRow( m_bgShiftLow & 0xff, m_bgShiftHigh & 0xff );
+
+	int x = SPAN_START_CYCLE - 2;
+	for ( int cycle = SPAN_START_CYCLE; cycle <= SPAN_END_CYCLE; cycle += 8 )
+	{
+		// shift registers are only reloaded after the 8th pixel
+		const int tileEnd = std::min( cycle + 7, SPAN_END_CYCLE );
+		const int numPixels = tileEnd - cycle + 1;
+
+		const uint64_t pixels = fineShift
+			? ( tilePixels >> fineShift ) | ( nextTilePixels << ( 64 - fineShift ) )
+			: tilePixels;
+
+		if ( m_renderOutput || m_spriteZeroThisScanline )
 		{
-			dbAssert( m_cartridge );
-			m_cartridge->signalScanline();
+			for ( int i = 0; i < numPixels; ++i, ++x )
+			{
+				Byte palette = 0;
+				if ( showBackground && ( showBackgroundLeft8 || ( x >= 8 ) ) )
+				{
+					palette = ( pixels >> ( i * 8 ) ) & 0x03;
+
+					if ( palette != 0 )
+					{
+						palette |= ( (Byte)getBit( m_attributeShiftHigh, attributeBit ) << 3 )
+							| ( (Byte)getBit( m_attributeShiftLow, attributeBit ) << 2 );
+					}
+				}
+				drawPixel( x, palette );
+
+				m_attributeShiftLow = ( m_attributeShiftLow << 1 ) | (Byte)m_attributeLatchLow;
+				m_attributeShiftHigh = ( m_attributeShiftHigh << 1 ) | (Byte)m_attributeLatchHigh;
+			}
+		}
+		else
+		{
+			// without render output only the attribute shifts are needed
+			const Byte fill = static_cast<Byte>( ( 1 << numPixels ) - 1 );
+			m_attributeShiftLow = static_cast<Byte>( ( m_attributeShiftLow << numPixels ) | ( m_attributeLatchLow ? fill : 0 ) );
+			m_attributeShiftHigh = static_cast<Byte>( ( m_attributeShiftHigh << numPixels ) | ( m_attributeLatchHigh ? fill : 0 ) );
+			x += numPixels;
 		}
+
+		m_bgShiftLow <<= numPixels;
+		m_bgShiftHigh <<= numPixels;
+
+		// tile fetches
+		m_nametableLatch = read( m_renderAddress );
+		m_renderAddress = getAttributeAddress();
+		fetchAttribute();
+		m_renderAddress = getBackgroundAddress();
+
+		// the last span ends before the high plane fetch
+		if ( tileEnd == SPAN_END_CYCLE )
+		{
+			m_bgLatchLow = read( m_renderAddress );
+			m_renderAddress += 8;
+			break;
+		}
+
+		dbAssert( m_cartridge );
+		const auto row = m_cartridge->readPatternRow( m_renderAddress );
+		m_bgLatchLow = row.low;
+		m_bgLatchHigh = row.high;
+		m_renderAddress += 8;
+		incrementXComponent();
+
+		m_renderAddress = getNametableAddress();
+		loadShiftRegisters();
+
+		tilePixels = nextTilePixels;
+		nextTilePixels = row.pixels;
 	}
+
+	m_cycle = SPAN_END_CYCLE;
+	m_clock = startClock + SPAN_END_CYCLE - ( SPAN_START_CYCLE - 1 );
+
+	if ( scanlineSignal )
+		updateScanlineSignal();
 }
 
 void Ppu::incrementXComponent()
@@ -841,10 +1292,49 @@ void Ppu::loadSpriteRegisters()
 		address += spriteY + ( spriteY & 0x08 );
 
 		// load registers
-		m_spriteShiftLow[ i ] = read( address );
-		m_spriteShiftHigh[ i ] = read( address + 8 );
+		dbAssert( m_cartridge );
+		const auto row = m_cartridge->readPatternRow( address );
+		const Byte attributes = object[ ObjectVariable::Attributes ];
+		m_spriteShiftLow[ i ] = row.low;
+		m_spriteShiftHigh[ i ] = row.high;
 		m_spriteXCounter[ i ] = object[ ObjectVariable::XPos ];
-		m_spriteAttributeLatch[ i ] = object[ ObjectVariable::Attributes ];
+		m_spriteAttributeLatch[ i ] = attributes;
+		m_spritePixels[ i ] = testFlag( attributes, FlipHorizontally ) ? TileCache::flipRow( row.pixels ) : row.pixels;
+	}
+
+	buildSpriteLine();
+}
+
+void Ppu::buildSpriteLine()
+{
+	std::fill( std::begin( m_spriteLine ), std::end( m_spriteLine ), 0 );
+
+	// without render output only sprite 0 is needed, for the hit flag
+	const Word spriteCount = m_renderOutput ? m_spritesOnThisScanline
+		: ( m_spriteZeroThisScanline ? std::min<Word>( m_spritesOnThisScanline, 1 ) : 0 );
+
+	// merge 8 pixels at a time, sprite pixels are stored leftmost first so this assumes a little endian host
+	for( Word i = 0; i < spriteCount; ++i )
+	{
+		const uint64_t pixels = m_spritePixels[ i ];
+		if ( pixels == 0 )
+			continue;
+
+		const Byte attributes = m_spriteAttributeLatch[ i ];
+		Byte flags = 16 | ( ( attributes & ObjectAttribute::SpritePalette ) << 2 );
+		if ( testFlag( attributes, ObjectAttribute::Priority ) )
+			flags |= SpriteLineBehind;
+		if ( i == 0 )
+			flags |= SpriteLineFirst;
+
+		Byte* dest = m_spriteLine + m_spriteXCounter[ i ];
+		uint64_t line;
+		std::memcpy( &line, dest, sizeof( line ) );
+
+		// lower sprite indices have priority so only fill pixels that are still transparent
+		const uint64_t mask = nonZeroBytes( pixels ) & ~nonZeroBytes( line );
+		line |= ( pixels | ( flags * 0x0101010101010101 ) ) & mask;
+		std::memcpy( dest, &line, sizeof( line ) );
 	}
 }
 
@@ -864,13 +1354,15 @@ void Ppu::renderPixelInternal()
 	if ( !renderingEnabled() )
 		return;
 
+	// without render output a pixel only matters if it can set the sprite 0 hit
+	if ( !m_renderOutput && !m_spriteZeroThisScanline )
+		return;
+
 	int x = m_cycle - 2;
 	if ( m_scanline >= (int)ScreenHeight || x < 0 || x >= (int)ScreenWidth )
 		return;
 
 	Byte palette = 0;
-	Byte objectPalette = 0;
-	bool objectPriority = false;
 
 	const bool showBackground = testFlag( m_mask, ShowBackground );
 	if ( showBackground
@@ -887,33 +1379,23 @@ void Ppu::renderPixelInternal()
 		}
 	}
 
+	drawPixel( x, palette );
+}
+
+// composites sprites over the background palette index
+void Ppu::drawPixel( int x, Byte palette )
+{
+	const bool showBackground = testFlag( m_mask, ShowBackground );
 	const bool showSprites = testFlag( m_mask, ShowSprite );
 	if ( showSprites
 		&& ( testFlag( m_mask, ShowSpriteLeft8 ) || ( x >= 8 ) )
 		&& ( x < 255 ) )
 	{
-		for( Word i = m_spritesOnThisScanline; i-- > 0; )
+		const Byte sprite = m_spriteLine[ x ];
+		if ( sprite != 0 )
 		{
-			Byte attributes = m_spriteAttributeLatch[ i ];
-
-			int spriteX = x - m_spriteXCounter[ i ];
-			if ( spriteX < 0 || spriteX >= 8 )
-				continue;
-
-			if ( testFlag( attributes, FlipHorizontally ) )
-			{
-				spriteX ^= 0x07;
-			}
-
-			Byte spritePalette = ( (Byte)getBit( m_spriteShiftHigh[ i ], 7 - spriteX ) << 1 )
-				| (Byte)getBit( m_spriteShiftLow[ i ], 7 - spriteX );
-
-			// continue if transparent
-			if ( spritePalette == 0 )
-				continue;
-
 			if ( m_spriteZeroThisScanline
-				&& ( i == 0 )
+				&& testFlag( sprite, SpriteLineFirst )
 				&& showBackground
 				&& ( palette != 0 ) )
 			{
@@ -921,111 +1403,115 @@ void Ppu::renderPixelInternal()
 				setStatusFlag( SpriteZeroHit );
 			}
 
-			spritePalette |= ( attributes & ObjectAttribute::SpritePalette ) << 2;
-			objectPalette = spritePalette + 16;
-			objectPriority = testFlag( attributes, ObjectAttribute::Priority );
+			if ( palette == 0 || !testFlag( sprite, SpriteLineBehind ) )
+				palette = sprite & SpriteLinePalette;
 		}
 	}
 
-	if ( ( objectPalette != 0 ) && ( palette == 0 || !objectPriority ) )
-	{
-		palette = objectPalette;
-	}
-
-	size_t paletteIndex = read( PALETTE_START + palette );
-	m_pixels[ m_scanline * ScreenWidth + x ] = s_nesColourPalette[ paletteIndex ];
+	if ( m_renderOutput )
+		m_frameBuffer[ m_scanline * ScreenWidth + x ] = read( PALETTE_START + palette ) & 0x3f;
 }
 
-#define writeBytes( var ) out.write( (const char*)&var, sizeof( var ) );
-#define readBytes( var ) in.read( (char*)&var, sizeof( var ) );
-
-void Ppu::saveState( std::ostream& out ) const
+void Ppu::saveState( ByteIO::Writer& writer ) const
 {
-	writeBytes( m_nametable )
-	writeBytes( m_palette )
-	writeBytes( m_primaryOAM )
-	writeBytes( m_secondaryOAM )
-	writeBytes( m_spriteShiftLow )
-	writeBytes( m_spriteShiftHigh )
-	writeBytes( m_spriteXCounter )
-	writeBytes( m_spriteAttributeLatch );
-
-	writeBytes( m_canDraw )
-	writeBytes( m_openBus )
-	writeBytes( m_readBuffer )
-	writeBytes( m_renderAddress )
-	writeBytes( m_writeToggle )
-	writeBytes( m_control )
-	writeBytes( m_mask )
-	writeBytes( m_status )
-	writeBytes( m_oamAddress )
-	writeBytes( m_vramAddress )
-	writeBytes( m_tempVRAMAddress )
-	writeBytes( m_fineXScroll )
-	writeBytes( m_supressVBlank )
-	writeBytes( m_bgLatchLow )
-	writeBytes( m_bgLatchHigh )
-	writeBytes( m_bgShiftLow )
-	writeBytes( m_bgShiftHigh )
-	writeBytes( m_attributeLatch )
-	writeBytes( m_attributeLatchLow )
-	writeBytes( m_attributeLatchHigh )
-	writeBytes( m_attributeShiftLow )
-	writeBytes( m_attributeShiftHigh )
-	writeBytes( m_nametableLatch )
-	writeBytes( m_spriteZeroNextScanline )
-	writeBytes( m_spriteZeroThisScanline )
-	writeBytes( m_spriteZeroHit )
-	writeBytes( m_cycle )
-	writeBytes( m_scanline )
-	writeBytes( m_spritesOnNextScanline )
-	writeBytes( m_spritesOnThisScanline )
-	writeBytes( m_oddFrame )
+	writer.write( m_nametable );
+	writer.write( m_palette );
+	writer.write( m_primaryOAM );
+	writer.write( m_secondaryOAM );
+	writer.write( m_spriteShiftLow );
+	writer.write( m_spriteShiftHigh );
+	writer.write( m_spriteXCounter );
+	writer.write( m_spriteAttributeLatch );
+
+	writer.write( m_canDraw );
+	writer.write( m_openBus );
+	writer.write( m_readBuffer );
+	writer.write( m_renderAddress );
+	writer.write( m_writeToggle );
+	writer.write( m_control );
+	writer.write( m_mask );
+	writer.write( m_status );
+	writer.write( m_oamAddress );
+	writer.write( m_vramAddress );
+	writer.write( m_tempVRAMAddress );
+	writer.write( m_fineXScroll );
+	writer.write( m_supressVBlank );
+	writer.write( m_bgLatchLow );
+	writer.write( m_bgLatchHigh );
+	writer.write( m_bgShiftLow );
+	writer.write( m_bgShiftHigh );
+	writer.write( m_attributeLatch );
+	writer.write( m_attributeLatchLow );
+	writer.write( m_attributeLatchHigh );
+	writer.write( m_attributeShiftLow );
+	writer.write( m_attributeShiftHigh );
+	writer.write( m_nametableLatch );
+	writer.write( m_spriteZeroNextScanline );
+	writer.write( m_spriteZeroThisScanline );
+	writer.write( m_spriteZeroHit );
+	writer.write( m_cycle );
+	writer.write( m_scanline );
+	writer.write( m_spritesOnNextScanline );
+	writer.write( m_spritesOnThisScanline );
+	writer.write( m_oddFrame );
 }
 
-void Ppu::loadState( std::istream& in )
+void Ppu::loadState( ByteIO::Reader& reader )
 {
-	readBytes( m_nametable )
-	readBytes( m_palette )
-	readBytes( m_primaryOAM )
-	readBytes( m_secondaryOAM )
-	readBytes( m_spriteShiftLow )
-	readBytes( m_spriteShiftHigh )
-	readBytes( m_spriteXCounter )
-	readBytes( m_spriteAttributeLatch );
+	reader.read( m_nametable );
+	reader.read( m_palette );
+	reader.read( m_primaryOAM );
+	reader.read( m_secondaryOAM );
+	reader.read( m_spriteShiftLow );
+	reader.read( m_spriteShiftHigh );
+	reader.read( m_spriteXCounter );
+	reader.read( m_spriteAttributeLatch );
 	
-	readBytes( m_canDraw )
-	readBytes( m_openBus )
-	readBytes( m_readBuffer )
-	readBytes( m_renderAddress )
-	readBytes( m_writeToggle )
-	readBytes( m_control )
-	readBytes( m_mask )
-	readBytes( m_status )
-	readBytes( m_oamAddress )
-	readBytes( m_vramAddress )
-	readBytes( m_tempVRAMAddress )
-	readBytes( m_fineXScroll )
-	readBytes( m_supressVBlank )
-	readBytes( m_bgLatchLow )
-	readBytes( m_bgLatchHigh )
-	readBytes( m_bgShiftLow )
-	readBytes( m_bgShiftHigh )
-	readBytes( m_attributeLatch )
-	readBytes( m_attributeLatchLow )
-	readBytes( m_attributeLatchHigh )
-	readBytes( m_attributeShiftLow )
-	readBytes( m_attributeShiftHigh )
-	readBytes( m_nametableLatch )
-	readBytes( m_spriteZeroNextScanline )
-	readBytes( m_spriteZeroThisScanline )
-	readBytes( m_spriteZeroHit )
-	readBytes( m_cycle )
-	readBytes( m_scanline )
-	readBytes( m_spritesOnNextScanline )
-	readBytes( m_spritesOnThisScanline )
-	readBytes( m_oddFrame )
-}
+	reader.read( m_canDraw );
+	reader.read( m_openBus );
+	reader.read( m_readBuffer );
+	reader.read( m_renderAddress );
+	reader.read( m_writeToggle );
+	reader.read( m_control );
+	reader.read( m_mask );
+	reader.read( m_status );
+	reader.read( m_oamAddress );
+	reader.read( m_vramAddress );
+	reader.read( m_tempVRAMAddress );
+	reader.read( m_fineXScroll );
+	reader.read( m_supressVBlank );
+	reader.read( m_bgLatchLow );
+	reader.read( m_bgLatchHigh );
+	reader.read( m_bgShiftLow );
+	reader.read( m_bgShiftHigh );
+	reader.read( m_attributeLatch );
+	reader.read( m_attributeLatchLow );
+	reader.read( m_attributeLatchHigh );
+	reader.read( m_attributeShiftLow );
+	reader.read( m_attributeShiftHigh );
+	reader.read( m_nametableLatch );
+	reader.read( m_spriteZeroNextScanline );
+	reader.read( m_spriteZeroThisScanline );
+	reader.read( m_spriteZeroHit );
+	reader.read( m_cycle );
+	reader.read( m_scanline );
+	reader.read( m_spritesOnNextScanline );
+	reader.read( m_spritesOnThisScanline );
+	reader.read( m_oddFrame );
+
+	// the counts index sprite arrays and the position drives the event schedule, so a corrupt state must not reach them
+	if ( m_cycle >= NUM_CYCLES || m_scanline >= NUM_SCANLINES )
+		throw ByteIO::Exception( "Save state has an invalid PPU position" );
+
+	if ( m_spritesOnNextScanline > PRIMARY_OAM_SIZE || m_spritesOnThisScanline > PRIMARY_OAM_SIZE )
+		throw ByteIO::Exception( "Save state has an invalid sprite count" );
+
+	for ( size_t i = 0; i < m_spritesOnThisScanline; ++i )
+	{
+		const uint64_t pixels = TileCache::decodeRow( m_spriteShiftLow[ i ], m_spriteShiftHigh[ i ] );
+		m_spritePixels[ i ] = testFlag( m_spriteAttributeLatch[ i ], FlipHorizontally ) ? TileCache::flipRow( pixels ) : pixels;
+	}
+	buildSpriteLine();
 
-#undef writeBytes
-#undef readBytes
\ No newline at end of file
+	updateNextEvent();
+}
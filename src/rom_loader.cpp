@@ -1,65 +1,73 @@
 #include "rom_loader.hpp"
 
-#include "Cartridge.hpp"
+#include "cartridge.hpp"
 
 #include "Header.hpp"
 
-#include "mappers/Mapper1.hpp"
-#include "mappers/Mapper2.hpp"
-#include "mappers/Mapper3.hpp"
-#include "mappers/Mapper4.hpp"
+#include "mappers/mapper1.hpp"
+#include "mappers/mapper2.hpp"
+#include "mappers/mapper3.hpp"
+#include "mappers/mapper4.hpp"
 
 #include "Memory.hpp"
 #include "types.hpp"
 
-#include "message.hpp" // TODO: remove
-
 #include <fstream>
+#include <string>
+#include <utility>
 
 using namespace nes;
 using namespace nes::Rom;
 
-std::unique_ptr<Cartridge> nes::Rom::load( const char* filename )
+namespace
 {
-
-	std::ifstream fin( filename, std::ios::binary );
-	if ( !fin.is_open() || !fin.good() || fin.eof() )
+	// fallback for files that can't be mapped
+	Memory readFile( const char* filename )
 	{
-		showError( "Error", std::string( "Could not open " ) + filename );
-		return nullptr;
+		std::ifstream fin( filename, std::ios::binary );
+		if ( !fin.is_open() || !fin.good() || fin.eof() )
+		{
+			throw LoadError( std::string( "Could not open " ) + filename );
+		}
+
+		fin.seekg( 0, std::ios::end );
+		size_t dataSize = static_cast<size_t>( fin.tellg() );
+		fin.seekg( 0 );
+
+		Memory data( dataSize );
+		fin.read( ( char* )data.data(), data.size() );
+		return data;
 	}
+}
 
-	// check file size
-	fin.seekg( 0, std::ios::end );
-	size_t dataSize = static_cast<size_t>( fin.tellg() );
-	fin.seekg( 0 );
+std::unique_ptr<Cartridge> nes::Rom::load( const char* filename, bool shared )
+{
+	// ROM data is never written so cartridges loaded from the same file can share one mapping
+	Memory data;
+	if ( shared )
+		data = Memory::mapFile( filename );
 
-	if ( dataSize < ( Rom::HeaderSize + 8 * KB ) )
+	if ( data.size() == 0 )
+		data = readFile( filename );
+
+	// check file size
+	if ( data.size() < ( Rom::HeaderSize + 8 * KB ) )
 	{
-		fin.close();
-		showError( "Error", "File too small" );
-		return nullptr;
+		throw LoadError( "File too small" );
 	}
 
-	Memory data( dataSize );
-
-	// read file
-	fin.read( ( char* )data.data(), data.size() );
-	fin.close();
-
-	if ( !Rom::isHeader( data.data() ) )
+	const Byte* header = std::as_const( data ).data();
+	if ( !Rom::isHeader( header ) )
 	{
-		showError( "Error", "ROM header is invalid" );
-		return nullptr;
+		throw LoadError( "ROM header is invalid" );
 	}
 
-	if ( Rom::isNes2Format( data.data() ) )
+	if ( Rom::isNes2Format( header ) )
 	{
-		showError( "Error", "NES 2.0 formatted ROMs are not supported yet" );
-		return nullptr;
+		throw LoadError( "NES 2.0 formatted ROMs are not supported yet" );
 	}
 
-	auto mapper_number = getMapperNumber( data.data() );
+	auto mapper_number = getMapperNumber( header );
 	switch ( mapper_number )
 	{
 		case 0: return std::make_unique<Cartridge>( std::move( data ) );
@@ -69,7 +77,6 @@ std::unique_ptr<Cartridge> nes::Rom::load( const char* filename )
 		case 4: return std::make_unique<Mapper4>( std::move( data ) );
 
 		default:
-			showError( "Error", "Mapper " + std::to_string( mapper_number ) + " is not supported" );
-			return nullptr;
+			throw LoadError( "Mapper " + std::to_string( mapper_number ) + " is not supported" );
 	}
 }
\ No newline at end of file
@@ -0,0 +1,288 @@
+#include "cartridge.hpp"
+#include "crc32.hpp"
+#include "InputMovie.hpp"
+#include "joypad.hpp"
+#include "Nes.hpp"
+#include "ppu.hpp"
+#include "rom_loader.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr int DefaultFrames = 3600;
+	constexpr size_t NumJoypads = 2;
+
+	struct Job
+	{
+		std::string rom;
+		std::string movie;
+		int frames = DefaultFrames;
+	};
+
+	struct Result
+	{
+		std::string error;
+		int framesRun = 0;
+		bool halted = false;
+		uint32_t lastFrameHash = 0;
+		uint32_t runHash = 0;
+		double milliseconds = 0;
+		std::vector<uint32_t> frameHashes;
+	};
+
+	// every emulator a worker owns, reused between jobs
+	struct Instance
+	{
+		Instance()
+		{
+			for( size_t i = 0; i < NumJoypads; ++i )
+				nes.setController( &joypads[ i ], i );
+
+			// random cpu alignment would make hashes differ between runs
+			nes.setClockSyncAlignment( 0 );
+		}
+
+		nes::Nes nes;
+		nes::Joypad joypads[ NumJoypads ];
+		nes::InputMovie movie;
+	};
+
+	void printUsage( const char* program )
+	{
+		std::printf( "usage: %s [-j threads] [--hashes] [--timing-only] <job file>\n", program );
+		std::printf( "each job file line is: <rom> [frames] [movie]\n" );
+		std::printf( "--timing-only draws and hashes only the last frame of each job\n" );
+	}
+
+	bool readJobs( const char* filename, std::vector<Job>& jobs )
+	{
+		std::ifstream fin( filename );
+		if ( !fin.is_open() )
+		{
+			std::fprintf( stderr, "cannot open job file %s\n", filename );
+			return false;
+		}
+
+		std::string line;
+		for( int lineNumber = 1; std::getline( fin, line ); ++lineNumber )
+		{
+			const size_t comment = line.find( '#' );
+			if ( comment != std::string::npos )
+				line.resize( comment );
+
+			std::istringstream in( line );
+			Job job;
+			if ( !( in >> job.rom ) )
+				continue;
+
+			std::string frames;
+			if ( in >> frames )
+			{
+				job.frames = std::atoi( frames.c_str() );
+				if ( job.frames <= 0 )
+				{
+					std::fprintf( stderr, "%s:%d: invalid frame count %s\n", filename, lineNumber, frames.c_str() );
+					return false;
+				}
+
+				in >> job.movie;
+			}
+
+			jobs.push_back( std::move( job ) );
+		}
+
+		return true;
+	}
+
+	void runJob( Instance& instance, const Job& job, bool timingOnly, Result& result )
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		std::unique_ptr<nes::Cartridge> cartridge;
+		try
+		{
+			// jobs on the same ROM share its data and decoded tiles
+			cartridge = nes::Rom::load( job.rom.c_str(), true );
+		}
+		catch( const nes::Rom::LoadError& e )
+		{
+			result.error = e.what();
+			return;
+		}
+
+		nes::InputMovie& movie = instance.movie;
+		movie.clear();
+		if ( !job.movie.empty() )
+		{
+			if ( !movie.load( job.movie ) )
+			{
+				result.error = "cannot load movie " + job.movie;
+				return;
+			}
+
+			if ( movie.getChecksum() != cartridge->getChecksum() )
+			{
+				result.error = "movie " + job.movie + " was recorded with a different cartridge";
+				return;
+			}
+		}
+
+		nes::Nes& nes = instance.nes;
+		nes.setCartridge( std::move( cartridge ) );
+		for( auto& joypad : instance.joypads )
+			joypad.reset();
+		nes.power();
+
+		constexpr size_t FrameSize = nes::Ppu::ScreenWidth * nes::Ppu::ScreenHeight;
+		result.frameHashes.reserve( job.frames );
+
+		uint32_t runHash = crc32Init();
+		bool playing = !movie.empty();
+		for( ; result.framesRun < job.frames && !nes.halted(); ++result.framesRun )
+		{
+			if ( playing )
+				playing = movie.updateInput( result.framesRun, instance.joypads, NumJoypads );
+
+			const bool render = !timingOnly || result.framesRun == job.frames - 1;
+			nes.setRenderOutput( render );
+			nes.runFrame();
+
+			if ( render )
+			{
+				const uint32_t frameHash = crc32( nes.getFrameBuffer(), FrameSize );
+				result.frameHashes.push_back( frameHash );
+				runHash = crc32Update( runHash, reinterpret_cast<const unsigned char*>( &frameHash ), sizeof( frameHash ) );
+			}
+		}
+
+		result.halted = nes.halted();
+		result.lastFrameHash = result.frameHashes.empty() ? 0 : result.frameHashes.back();
+		result.runHash = crc32Final( runHash );
+
+		// release the cartridge before the next job loads its own
+		nes.setCartridge( nullptr );
+		nes.setRenderOutput( true );
+
+		const auto end = std::chrono::steady_clock::now();
+		result.milliseconds = std::chrono::duration<double, std::milli>( end - start ).count();
+	}
+}
+
+int main( int argc, char** argv )
+{
+	int threads = static_cast<int>( std::thread::hardware_concurrency() );
+	bool printFrameHashes = false;
+	bool timingOnly = false;
+	const char* jobFilename = nullptr;
+
+	for( int i = 1; i < argc; ++i )
+	{
+		if ( std::strcmp( argv[ i ], "-j" ) == 0 && i + 1 < argc )
+		{
+			threads = std::atoi( argv[ ++i ] );
+		}
+		else if ( std::strcmp( argv[ i ], "--hashes" ) == 0 )
+		{
+			printFrameHashes = true;
+		}
+		else if ( std::strcmp( argv[ i ], "--timing-only" ) == 0 )
+		{
+			timingOnly = true;
+		}
+		else if ( !jobFilename )
+		{
+			jobFilename = argv[ i ];
+		}
+		else
+		{
+			printUsage( argv[ 0 ] );
+			return 1;
+		}
+	}
+
+	if ( !jobFilename || threads < 0 )
+	{
+		printUsage( argv[ 0 ] );
+		return 1;
+	}
+
+	std::vector<Job> jobs;
+	if ( !readJobs( jobFilename, jobs ) )
+		return 1;
+
+	threads = std::clamp( threads, 1, std::max( static_cast<int>( jobs.size() ), 1 ) );
+
+	std::vector<Result> results( jobs.size() );
+	std::atomic<size_t> nextJob{ 0 };
+
+	auto worker = [&]
+	{
+		auto instance = std::make_unique<Instance>();
+		for( size_t i = nextJob++; i < jobs.size(); i = nextJob++ )
+			runJob( *instance, jobs[ i ], timingOnly, results[ i ] );
+	};
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for( int i = 0; i < threads; ++i )
+		workers.emplace_back( worker );
+
+	for( auto& thread : workers )
+		thread.join();
+
+	const auto end = std::chrono::steady_clock::now();
+
+	int failed = 0;
+	long long totalFrames = 0;
+	for( size_t i = 0; i < jobs.size(); ++i )
+	{
+		const Job& job = jobs[ i ];
+		const Result& result = results[ i ];
+
+		if ( !result.error.empty() )
+		{
+			std::printf( "%zu %s error: %s\n", i, job.rom.c_str(), result.error.c_str() );
+			++failed;
+			continue;
+		}
+
+		std::printf( "%zu %s frames=%d last=%08x run=%08x time=%.1fms%s\n",
+			i,
+			job.rom.c_str(),
+			result.framesRun,
+			result.lastFrameHash,
+			result.runHash,
+			result.milliseconds,
+			result.halted ? " halted" : "" );
+
+		if ( printFrameHashes )
+		{
+			for( size_t frame = 0; frame < result.frameHashes.size(); ++frame )
+				std::printf( "  %zu %08x\n", frame, result.frameHashes[ frame ] );
+		}
+
+		totalFrames += result.framesRun;
+	}
+
+	const double seconds = std::chrono::duration<double>( end - start ).count();
+	std::printf( "jobs:           %zu (%d failed)\n", jobs.size(), failed );
+	std::printf( "threads:        %d\n", threads );
+	std::printf( "time:           %.3f s\n", seconds );
+	std::printf( "frames/sec:     %.1f\n", totalFrames / seconds );
+
+	return failed == 0 ? 0 : 1;
+}
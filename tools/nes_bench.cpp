@@ -0,0 +1,95 @@
+#include "cartridge.hpp"
+#include "cpu.hpp"
+#include "Nes.hpp"
+#include "rom_loader.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+	constexpr int DefaultFrames = 3600;
+
+	void printUsage( const char* program )
+	{
+		std::printf( "usage: %s [--timing-only] <rom> [frames]\n", program );
+	}
+}
+
+int main( int argc, char** argv )
+{
+	bool timingOnly = false;
+	const char* romFilename = nullptr;
+	int frames = DefaultFrames;
+
+	for( int i = 1; i < argc; ++i )
+	{
+		if ( std::strcmp( argv[ i ], "--timing-only" ) == 0 )
+		{
+			timingOnly = true;
+		}
+		else if ( !romFilename )
+		{
+			romFilename = argv[ i ];
+		}
+		else
+		{
+			frames = std::atoi( argv[ i ] );
+		}
+	}
+
+	if ( !romFilename || frames <= 0 )
+	{
+		printUsage( argv[ 0 ] );
+		return 1;
+	}
+
+	std::unique_ptr<nes::Cartridge> cartridge;
+	try
+	{
+		cartridge = nes::Rom::load( romFilename );
+	}
+	catch( const nes::Rom::LoadError& e )
+	{
+		std::fprintf( stderr, "%s: %s\n", romFilename, e.what() );
+		return 1;
+	}
+
+	// no video or audio consumers, the frame is only emulated
+	auto nes = std::make_unique<nes::Nes>();
+	nes->setCartridge( std::move( cartridge ) );
+	nes->setRenderOutput( !timingOnly );
+	nes->power();
+
+	uint64_t cpuCycles = 0;
+	int framesRun = 0;
+
+	const auto start = std::chrono::steady_clock::now();
+	for ( ; framesRun < frames && !nes->halted(); ++framesRun )
+	{
+		nes->runFrame();
+		cpuCycles += nes->cpu.getCycles();
+	}
+	const auto end = std::chrono::steady_clock::now();
+
+	if ( nes->halted() )
+		std::fprintf( stderr, "CPU halted at $%04x after %d frames\n", nes->cpu.getProgramCounter() - 1, framesRun );
+
+	const double seconds = std::chrono::duration<double>( end - start ).count();
+	const double nanoseconds = seconds * 1e9;
+	const uint64_t ppuDots = cpuCycles * nes::Cpu::PpuDotsPerCycle;
+
+	std::printf( "rom:            %s (%s)\n", romFilename, nes->getCartridge()->getName() );
+	std::printf( "frames:         %d%s\n", framesRun, timingOnly ? " (timing only)" : "" );
+	std::printf( "cpu cycles:     %llu\n", static_cast<unsigned long long>( cpuCycles ) );
+	std::printf( "time:           %.3f s\n", seconds );
+	std::printf( "frames/sec:     %.1f\n", framesRun / seconds );
+	std::printf( "ns/cpu cycle:   %.3f\n", cpuCycles ? nanoseconds / cpuCycles : 0.0 );
+	std::printf( "ns/ppu dot:     %.3f\n", ppuDots ? nanoseconds / ppuDots : 0.0 );
+
+	return 0;
+}